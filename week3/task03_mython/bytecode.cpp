@@ -0,0 +1,329 @@
+#include "bytecode.h"
+#include "statement.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace Bytecode {
+
+    const Code &Program::GetMethodCode(const Runtime::Method &method) const {
+        return methods.at(&method);
+    }
+
+    Compiler::Compiler(Program &program) : program_(program) {}
+
+    void Compiler::CompileMain(Ast::Statement &statement) {
+        code_ = &program_.main;
+        jump_target_ = 0;
+        Compile(statement);
+        Emit(OpCode::RETURN);
+    }
+
+    void Compiler::Compile(Ast::Statement &statement) {
+        statement.Compile(*this);
+    }
+
+    void Compiler::Emit(OpCode op, uint32_t arg, uint16_t count) {
+        code_->instructions.push_back({op, count, arg});
+    }
+
+    size_t Compiler::EmitJump(OpCode op, uint16_t count) {
+        Emit(op, 0, count);
+        return code_->instructions.size() - 1;
+    }
+
+    void Compiler::PatchJump(size_t jump) {
+        jump_target_ = code_->instructions.size();
+        code_->instructions[jump].arg = jump_target_;
+    }
+
+    void Compiler::EmitPop() {
+        auto &instructions = code_->instructions;
+        if (!instructions.empty() && instructions.size() != jump_target_) {
+            auto &last = instructions.back();
+            if (last.op == OpCode::LOAD_NULL) {
+                instructions.pop_back();
+                return;
+            }
+            if ((last.op == OpCode::STORE_VARIABLE || last.op == OpCode::STORE_LOCAL || last.op == OpCode::STORE_FIELD)
+                && last.count == 1) {
+                last.count = 0;
+                return;
+            }
+        }
+        Emit(OpCode::POP);
+    }
+
+    uint32_t Compiler::AddConstant(ObjectHolder constant) {
+        program_.constants.push_back(move(constant));
+        return program_.constants.size() - 1;
+    }
+
+    optional<uint32_t> Compiler::FindLocalSlot(const string &name) {
+        if (local_slots_ == nullptr) {
+            return nullopt;
+        }
+        auto[it, inserted] = local_slots_->insert({name, code_->local_names.size()});
+        if (inserted) {
+            code_->local_names.push_back(name);
+        }
+        return it->second;
+    }
+
+    void Compiler::EmitLoadVariable(const string &name, bool as_field_assignment_object) {
+        if (auto slot = FindLocalSlot(name)) {
+            Emit(OpCode::LOAD_LOCAL, *slot, as_field_assignment_object);
+        } else {
+            Emit(OpCode::LOAD_VARIABLE, AddName(name), as_field_assignment_object);
+        }
+    }
+
+    void Compiler::EmitStoreVariable(const string &name) {
+        if (auto slot = FindLocalSlot(name)) {
+            Emit(OpCode::STORE_LOCAL, *slot, 1);
+        } else {
+            Emit(OpCode::STORE_VARIABLE, AddName(name), 1);
+        }
+    }
+
+    void Compiler::EmitDefineClass(const ObjectHolder &cls) {
+        const uint32_t constant = AddConstant(cls);
+        if (auto slot = FindLocalSlot(cls.TryAs<Runtime::Class>()->GetName())) {
+            Emit(OpCode::LOAD_CONST, constant);
+            Emit(OpCode::DEFINE_LOCAL, *slot);
+        } else {
+            Emit(OpCode::DEFINE_CLASS, constant);
+        }
+    }
+
+    uint32_t Compiler::AddName(const string &name) {
+        auto[it, inserted] = name_ids_.insert({name, program_.names.size()});
+        if (inserted) {
+            program_.names.push_back(name);
+        }
+        return it->second;
+    }
+
+    uint32_t Compiler::AddComparison(const Comparator &comparator, optional<Runtime::ComparisonKind> kind) {
+        program_.comparisons.push_back({&comparator, kind, AddCallSite("__eq__"), AddCallSite("__lt__")});
+        return program_.comparisons.size() - 1;
+    }
+
+    uint32_t Compiler::AddFieldSite(const string &name) {
+        program_.field_sites.push_back(AddName(name));
+        return program_.field_sites.size() - 1;
+    }
+
+    uint32_t Compiler::AddCallSite(const string &method) {
+        program_.call_sites.push_back(AddName(method));
+        return program_.call_sites.size() - 1;
+    }
+
+    uint32_t Compiler::AddClass(const Runtime::Class &cls) {
+        auto[it, inserted] = class_ids_.insert({&cls, program_.classes.size()});
+        if (inserted) {
+            program_.classes.push_back(&cls);
+            if (cls.GetParent() != nullptr) {
+                AddClass(*cls.GetParent());
+            }
+            for (const auto &[name, method] : cls.GetOwnMethods()) {
+                CompileMethod(method);
+            }
+        }
+        return it->second;
+    }
+
+    void Compiler::CompileMethod(const Runtime::Method &method) {
+        Code *outer_code = code_;
+        const size_t outer_jump_target = jump_target_;
+        auto *outer_local_slots = local_slots_;
+
+        code_ = &program_.methods[&method];
+        jump_target_ = 0;
+        unordered_map<string, uint32_t> local_slots;
+        local_slots_ = &local_slots;
+
+        // The frame starts with the arguments, a repeated name is the first of them, as in CreateArgsClosure
+        code_->local_names.push_back("self");
+        local_slots.insert({"self", 0});
+        for (const auto &param : method.formal_params) {
+            local_slots.insert({param, code_->local_names.size()});
+            code_->local_names.push_back(param);
+        }
+        Compile(*method.body);
+        Emit(OpCode::RETURN);
+
+        code_ = outer_code;
+        jump_target_ = outer_jump_target;
+        local_slots_ = outer_local_slots;
+    }
+
+    Program Compile(Ast::Statement &program) {
+        Program result;
+        Compiler(result).CompileMain(program);
+        return result;
+    }
+
+} /* namespace Bytecode */
+
+namespace Ast {
+
+    using Bytecode::Compiler;
+    using Bytecode::OpCode;
+
+    template<typename T>
+    void ValueStatement<T>::Compile(Compiler &compiler) {
+        compiler.Emit(OpCode::LOAD_CONST, compiler.AddConstant(HoldValue()));
+    }
+
+    template void ValueStatement<Runtime::Number>::Compile(Compiler &compiler);
+
+    template void ValueStatement<Runtime::String>::Compile(Compiler &compiler);
+
+    template void ValueStatement<Runtime::Bool>::Compile(Compiler &compiler);
+
+    void None::Compile(Compiler &compiler) {
+        compiler.Emit(OpCode::LOAD_NONE);
+    }
+
+    void VariableValue::Compile(Compiler &compiler) {
+        compiler.EmitLoadVariable(dotted_ids.front());
+        for (size_t i = 1; i < dotted_ids.size(); i++) {
+            compiler.Emit(OpCode::LOAD_FIELD, compiler.AddFieldSite(dotted_ids[i]));
+        }
+    }
+
+    void Assignment::Compile(Compiler &compiler) {
+        compiler.Compile(*right_value);
+        compiler.EmitStoreVariable(var_name);
+    }
+
+    void FieldAssignment::Compile(Compiler &compiler) {
+        compiler.EmitLoadVariable(object.dotted_ids.front(), true);
+        for (size_t i = 1; i < object.dotted_ids.size(); i++) {
+            compiler.Emit(OpCode::LOAD_FIELD, compiler.AddFieldSite(object.dotted_ids[i]), 1);
+        }
+        compiler.Compile(*right_value);
+        compiler.Emit(OpCode::STORE_FIELD, compiler.AddFieldSite(field_name), 1);
+    }
+
+    void Print::Compile(Compiler &compiler) {
+        // Every argument is printed before the next one is evaluated
+        for (size_t i = 0; i < args.size(); i++) {
+            if (i > 0) {
+                compiler.Emit(OpCode::PRINT_SPACE);
+            }
+            compiler.Compile(*args[i]);
+            compiler.Emit(OpCode::PRINT, compiler.AddCallSite("__str__"));
+        }
+        compiler.Emit(OpCode::PRINT_NEWLINE);
+        compiler.Emit(OpCode::LOAD_NULL);
+    }
+
+    void MethodCall::Compile(Compiler &compiler) {
+        compiler.Compile(*object);
+        for (const auto &arg : args) {
+            compiler.Compile(*arg);
+        }
+        compiler.Emit(OpCode::CALL_METHOD, compiler.AddCallSite(method), args.size());
+    }
+
+    void NewInstance::Compile(Compiler &compiler) {
+        compiler.Emit(OpCode::NEW_INSTANCE, compiler.AddClass(class_));
+        // The arguments are evaluated only if there is __init__ to take them, the class is known here
+        if (const Runtime::Method *init = class_.GetMethod("__init__"); init && init->formal_params.size() == args.size()) {
+            for (const auto &arg : args) {
+                compiler.Compile(*arg);
+            }
+            compiler.Emit(OpCode::CALL_INIT, compiler.AddCallSite("__init__"), args.size());
+        }
+    }
+
+    void Stringify::Compile(Compiler &compiler) {
+        compiler.Compile(*argument);
+        compiler.Emit(OpCode::STRINGIFY, compiler.AddCallSite("__str__"));
+    }
+
+    void Add::Compile(Compiler &compiler) {
+        compiler.Compile(*lhs);
+        compiler.Compile(*rhs);
+        compiler.Emit(OpCode::ADD, compiler.AddCallSite("__add__"));
+    }
+
+    void Sub::Compile(Compiler &compiler) {
+        compiler.Compile(*lhs);
+        compiler.Compile(*rhs);
+        compiler.Emit(OpCode::SUB, compiler.AddCallSite("__sub__"));
+    }
+
+    void Mult::Compile(Compiler &compiler) {
+        compiler.Compile(*lhs);
+        compiler.Compile(*rhs);
+        compiler.Emit(OpCode::MULT, compiler.AddCallSite("__mul__"));
+    }
+
+    void Div::Compile(Compiler &compiler) {
+        compiler.Compile(*lhs);
+        compiler.Compile(*rhs);
+        compiler.Emit(OpCode::DIV, compiler.AddCallSite("__div__"));
+    }
+
+    // Both operands are evaluated, as in Execute
+    void Or::Compile(Compiler &compiler) {
+        compiler.Compile(*lhs);
+        compiler.Compile(*rhs);
+        compiler.Emit(OpCode::OR);
+    }
+
+    void And::Compile(Compiler &compiler) {
+        compiler.Compile(*lhs);
+        compiler.Compile(*rhs);
+        compiler.Emit(OpCode::AND);
+    }
+
+    void Not::Compile(Compiler &compiler) {
+        compiler.Compile(*argument);
+        compiler.Emit(OpCode::NOT);
+    }
+
+    void Compound::Compile(Compiler &compiler) {
+        for (const auto &st : statements) {
+            compiler.Compile(*st);
+            compiler.EmitPop();
+        }
+        compiler.Emit(OpCode::LOAD_NONE);
+    }
+
+    // Leaves the code wherever the return is nested, so the value it leaves on the stack is never used
+    void Return::Compile(Compiler &compiler) {
+        compiler.Compile(*statement);
+        compiler.Emit(OpCode::RETURN);
+    }
+
+    void ClassDefinition::Compile(Compiler &compiler) {
+        compiler.AddClass(*cls.TryAs<Runtime::Class>());
+        compiler.EmitDefineClass(cls);
+    }
+
+    void IfElse::Compile(Compiler &compiler) {
+        compiler.Compile(*condition);
+        const size_t else_jump = compiler.EmitJump(OpCode::JUMP_IF_FALSE);
+        compiler.Compile(*if_body);
+        const size_t end_jump = compiler.EmitJump(OpCode::JUMP);
+        compiler.PatchJump(else_jump);
+        if (else_body) {
+            compiler.Compile(*else_body);
+        } else {
+            compiler.Emit(OpCode::LOAD_NONE);
+        }
+        compiler.PatchJump(end_jump);
+    }
+
+    void Comparison::Compile(Compiler &compiler) {
+        compiler.Compile(*left);
+        compiler.Compile(*right);
+        compiler.Emit(OpCode::COMPARE, compiler.AddComparison(comparator, kind));
+    }
+
+} /* namespace Ast */
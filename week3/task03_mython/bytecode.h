@@ -0,0 +1,155 @@
+#pragma once
+
+#include "comparators.h"
+#include "object_holder.h"
+#include "object.h"
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class TestRunner;
+
+namespace Ast {
+    struct Statement;
+}
+
+namespace Bytecode {
+
+    // The VM keeps the values on a stack; "top" below is the last pushed value
+    enum class OpCode : uint8_t {
+        LOAD_CONST,       // pushes constants[arg]
+        LOAD_NONE,        // pushes a new None
+        LOAD_NULL,        // pushes an empty holder, the value of print
+        LOAD_VARIABLE,    // pushes the top-level variable names[arg]; count 1 - of the object of a field assignment, missing is out_of_range
+        LOAD_LOCAL,       // pushes the local variable in slot arg of the frame; count as for LOAD_VARIABLE
+        LOAD_FIELD,       // replaces the instance on top with its field of the field site arg; count as for LOAD_VARIABLE
+        STORE_VARIABLE,   // assigns top to the top-level variable names[arg]; count 1 - keeps top, 0 - pops it
+        STORE_LOCAL,      // assigns top to the local variable in slot arg; count as for STORE_VARIABLE
+        STORE_FIELD,      // assigns top to the field of the field site arg of the instance under it and pops both; count 1 - pushes the value back
+        POP,
+        PRINT,            // pops and prints top, call_sites[arg] is of its __str__
+        PRINT_SPACE,
+        PRINT_NEWLINE,
+        STRINGIFY,        // replaces top with the string it prints as, as PRINT
+        ADD,              // pops rhs and lhs, pushes the result; call_sites[arg] is of the method for an instance lhs
+        SUB,
+        MULT,
+        DIV,
+        OR,
+        AND,
+        NOT,
+        COMPARE,          // pops rhs and lhs, pushes the result of comparisons[arg] of them
+        CALL_METHOD,      // pops count arguments and the instance under them, pushes the result of its method call_sites[arg]
+        NEW_INSTANCE,     // pushes a new instance of classes[arg]
+        CALL_INIT,        // pops count arguments and calls __init__ of the instance under them, keeping it; arg as for CALL_METHOD
+        DEFINE_CLASS,     // adds the class constants[arg] to the top-level variables unless there is such a name, pushes it
+        DEFINE_LOCAL,     // assigns top to the local variable in slot arg unless it is set, keeps top
+        JUMP,             // to arg
+        JUMP_IF_FALSE,    // pops top and jumps to arg if it is not true
+        RETURN,           // ends the code with top as its result
+    };
+
+    struct Instruction {
+        OpCode op;
+        uint16_t count = 0;  // of the arguments, or a flag of the op
+        uint32_t arg = 0;    // index in a table of the program, or a jump target
+    };
+
+    // The top-level code keeps its variables in a closure by names. The variables of a method are in the slots
+    // of its frame: self, the parameters and then the other variables of the method, resolved when it is compiled
+    struct Code {
+        std::vector<Instruction> instructions;
+        std::vector<std::string> local_names;  // by slots, empty for the top-level code
+    };
+
+    using Comparator = std::function<bool(const ObjectHolder &, const ObjectHolder &)>;
+
+    // An instance is compared by the methods of the call sites, unless the comparator is not of comparators.h
+    struct ComparisonSite {
+        const Comparator *comparator;
+        std::optional<Runtime::ComparisonKind> kind;
+        uint32_t equal_call_site;
+        uint32_t less_call_site;
+    };
+
+    // Points into the tree it is compiled from, so the tree must outlive it
+    struct Program {
+        Code main;
+        std::unordered_map<const Runtime::Method *, Code> methods;
+
+        std::vector<ObjectHolder> constants;
+        std::vector<std::string> names;
+        std::vector<ComparisonSite> comparisons;
+        std::vector<const Runtime::Class *> classes;
+        std::vector<uint32_t> field_sites;  // names of the fields accessed by LOAD_FIELD and STORE_FIELD, the VM caches their offsets by sites
+        std::vector<uint32_t> call_sites;   // names of the methods called by the instructions, the VM caches the methods by sites
+
+        const Code &GetMethodCode(const Runtime::Method &method) const;
+    };
+
+    // Used by Ast::Statement::Compile of every node
+    class Compiler {
+    public:
+        explicit Compiler(Program &program);
+
+        void CompileMain(Ast::Statement &statement);
+
+        void Compile(Ast::Statement &statement);
+
+        void Emit(OpCode op, uint32_t arg = 0, uint16_t count = 0);
+
+        // Returns the jump to pass to PatchJump
+        size_t EmitJump(OpCode op, uint16_t count = 0);
+
+        // Targets the jump at the next instruction
+        void PatchJump(size_t jump);
+
+        // Discards the value of the statement compiled last
+        void EmitPop();
+
+        uint32_t AddConstant(ObjectHolder constant);
+
+        // Of the local variable in a method, of the top-level one otherwise
+        void EmitLoadVariable(const std::string &name, bool as_field_assignment_object = false);
+
+        // Keeps the value on the stack
+        void EmitStoreVariable(const std::string &name);
+
+        void EmitDefineClass(const ObjectHolder &cls);
+
+        uint32_t AddName(const std::string &name);
+
+        // The kind is of the comparator if it is of comparators.h, instances are compared by their methods then
+        uint32_t AddComparison(const Comparator &comparator, std::optional<Runtime::ComparisonKind> kind);
+
+        uint32_t AddFieldSite(const std::string &name);
+
+        uint32_t AddCallSite(const std::string &method);
+
+        // Compiles the methods of the class and of its bases
+        uint32_t AddClass(const Runtime::Class &cls);
+
+    private:
+        void CompileMethod(const Runtime::Method &method);
+
+        // Slot of the local variable, a new one for a new name; nullopt in the top-level code
+        std::optional<uint32_t> FindLocalSlot(const std::string &name);
+
+        Program &program_;
+        Code *code_ = nullptr;
+        size_t jump_target_ = 0;  // the last position a jump targets in code_, not to be changed by EmitPop
+        std::unordered_map<std::string, uint32_t> *local_slots_ = nullptr;  // of the method being compiled
+
+        std::unordered_map<std::string, uint32_t> name_ids_;
+        std::unordered_map<const Runtime::Class *, uint32_t> class_ids_;
+    };
+
+    Program Compile(Ast::Statement &program);
+
+    void RunBytecodeTests(TestRunner &tr);
+
+} /* namespace Bytecode */
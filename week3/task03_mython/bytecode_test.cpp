@@ -0,0 +1,347 @@
+#include "bytecode.h"
+#include "vm.h"
+#include "lexer.h"
+#include "parse.h"
+#include "statement.h"
+
+#include <test_runner.h>
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace Bytecode {
+
+    unique_ptr<Ast::Statement> ParseProgramFromString(const string &program) {
+        istringstream is(program);
+        Parse::Lexer lexer(is);
+        return ParseProgram(lexer);
+    }
+
+    string RunOnTreeWalker(const string &program) {
+        ostringstream os;
+        Ast::Print::SetOutputStream(os);
+
+        Runtime::Closure closure;
+        ParseProgramFromString(program)->Execute(closure);
+        return os.str();
+    }
+
+    string RunOnVm(const string &program) {
+        ostringstream os;
+        auto tree = ParseProgramFromString(program);
+        const Program bytecode = Compile(*tree);
+
+        Runtime::Closure closure;
+        VirtualMachine(bytecode, os).Run(closure);
+        return os.str();
+    }
+
+#define ASSERT_RUNS_AS_TREE(program, expected) \
+{                                              \
+  ASSERT_EQUAL(RunOnTreeWalker(program), expected); \
+  ASSERT_EQUAL(RunOnVm(program), expected);    \
+}
+
+    void TestStatementValuesArePopped() {
+        auto tree = ParseProgramFromString("x = 1\nprint x\n");
+        const Program bytecode = Compile(*tree);
+
+        vector<OpCode> ops;
+        for (const auto &instruction : bytecode.main.instructions) {
+            ops.push_back(instruction.op);
+        }
+        const vector<OpCode> expected = {
+                OpCode::LOAD_CONST, OpCode::STORE_VARIABLE,
+                OpCode::LOAD_VARIABLE, OpCode::PRINT, OpCode::PRINT_NEWLINE,
+                OpCode::LOAD_NONE, OpCode::RETURN
+        };
+        ASSERT(ops == expected);
+        ASSERT_EQUAL(bytecode.main.instructions[1].count, 0u);
+    }
+
+    void TestMethodVariablesAreInSlots() {
+        auto tree = ParseProgramFromString(R"(
+class Counter:
+  def add(x, y):
+    sum = x + y
+    self.value = sum
+    return sum
+
+c = Counter()
+print c.add(2, 3), c.value
+)");
+        const Program bytecode = Compile(*tree);
+
+        ASSERT_EQUAL(bytecode.methods.size(), 1u);
+        const Code &code = bytecode.methods.begin()->second;
+        ASSERT_EQUAL(code.local_names, (vector<string>{"self", "x", "y", "sum"}));
+        for (const auto &instruction : code.instructions) {
+            ASSERT(instruction.op != OpCode::LOAD_VARIABLE && instruction.op != OpCode::STORE_VARIABLE);
+        }
+
+        ostringstream os;
+        Runtime::Closure closure;
+        VirtualMachine(bytecode, os).Run(closure);
+        ASSERT_EQUAL(os.str(), "5 5\n");
+    }
+
+    void TestMethodsDoNotSeeTopLevelVariables() {
+        const string program = R"(
+class Reader:
+  def read():
+    return x
+
+x = 1
+r = Reader()
+print r.read()
+)";
+        ASSERT_THROWS(RunOnTreeWalker(program), runtime_error);
+        ASSERT_THROWS(RunOnVm(program), runtime_error);
+    }
+
+    void TestMethodsAndInheritance() {
+        const string program = R"(
+class Shape:
+  def __init__(name):
+    self.name = name
+
+  def describe():
+    return self.name + ' with area ' + str(self.area())
+
+class Rect(Shape):
+  def __init__(w, h):
+    self.name = 'rect'
+    self.w = w
+    self.h = h
+
+  def area():
+    return self.w * self.h
+
+class Square(Rect):
+  def __init__(a):
+    self.name = 'square'
+    self.w = a
+    self.h = a
+
+shapes = Rect(2, 3)
+print shapes.describe()
+s = Square(4)
+print s.describe(), s.w
+)";
+        ASSERT_RUNS_AS_TREE(program, "rect with area 6\nsquare with area 16 4\n");
+    }
+
+    void TestRecursion() {
+        const string program = R"(
+class Fib:
+  def calc(n):
+    if n < 2:
+      return n
+    return self.calc(n - 1) + self.calc(n - 2)
+
+f = Fib()
+print f.calc(15)
+)";
+        ASSERT_RUNS_AS_TREE(program, "610\n");
+    }
+
+    void TestReturns() {
+        // A return ends the method from any depth, even with None, an if without a return does not
+        const string program = R"(
+class R:
+  def first(x):
+    if x > 0:
+      if x > 10:
+        return 'big'
+      else:
+        return 'small'
+    return 'not positive'
+
+  def none(x):
+    if x:
+      return None
+    return 'after'
+
+  def nothing():
+    y = 1
+
+  def deep(x):
+    if x:
+      if x > 1:
+        if x > 2:
+          return False
+        y = 2
+      else:
+        return None
+      print 'fell through', x
+    return 'end'
+
+r = R()
+print r.first(20), r.first(5), r.first(-1), r.none(True), r.nothing()
+print r.deep(3), r.deep(1), r.deep(2), r.deep(0)
+)";
+        ASSERT_RUNS_AS_TREE(program, "big small not positive None None\n"
+                                     "False None fell through 2\nend end\n");
+    }
+
+    void TestEvaluationOrder() {
+        const string program = R"(
+class Noisy:
+  def value(x):
+    print 'value', x
+    return x
+
+n = Noisy()
+print 'first', n.value(1), n.value(2)
+print n.value(True) or n.value(False), not n.value(0)
+print n.value(3) < n.value(4), n.value('a') + n.value('b')
+)";
+        ASSERT_RUNS_AS_TREE(program,
+                            "first value 1\n1 value 2\n2\n"
+                            "value True\nvalue False\nTrue value 0\nTrue\n"
+                            "value 3\nvalue 4\nTrue value a\nvalue b\nab\n");
+    }
+
+    void TestOperatorsOfInstances() {
+        const string program = R"(
+class Money:
+  def __init__(amount):
+    self.amount = amount
+
+  def __add__(other):
+    return self.amount + other.amount
+
+  def __str__():
+    return str(self.amount) + ' RUB'
+
+class Wrapper:
+  def __init__(inner):
+    self.inner = inner
+
+  def __str__():
+    return self.inner
+
+a = Money(10)
+b = Money(32)
+print a + b, str(a) + '!', Wrapper(Money(7))
+)";
+        ASSERT_RUNS_AS_TREE(program, "42 10 RUB! 7 RUB\n");
+    }
+
+    void TestComparisonsOfInstances() {
+        const string program = R"(
+class Money:
+  def __init__(amount):
+    self.amount = amount
+
+  def __eq__(other):
+    return self.amount == other.amount
+
+  def __lt__(other):
+    return self.amount < other.amount
+
+class Rub(Money):
+  def __init__(amount):
+    self.amount = amount
+
+a = Rub(1)
+b = Money(2)
+c = Rub(2)
+print a < b, a > b, a <= b, a >= b, a == b, a != b
+print b < c, b > c, b <= c, b >= c, b == c, b != c
+print 1 < 2, 'a' == 'a'
+)";
+        ASSERT_RUNS_AS_TREE(program,
+                            "True False True False False True\n"
+                            "False False True True True False\n"
+                            "True True\n");
+        ASSERT_THROWS(RunOnTreeWalker("class A:\n  def f():\n    return 1\nprint A() < A()\n"), runtime_error);
+        ASSERT_THROWS(RunOnVm("class A:\n  def f():\n    return 1\nprint A() < A()\n"), runtime_error);
+    }
+
+    void TestPolymorphicCallSites() {
+        // The call site in describe sees more classes than its cache keeps
+        const string program = R"(
+class A:
+  def name():
+    return 'k'
+
+class B(A):
+  def name():
+    return 'm'
+
+class C(B):
+  def other():
+    return 'c'
+
+class D(C):
+  def name():
+    return 'p'
+
+class E(D):
+  def other():
+    return 'e'
+
+class F(A):
+  def __str__():
+    return 'z'
+
+class Printer:
+  def describe(x):
+    return x.name() + str(x)
+
+p = Printer()
+print p.describe(A()) + p.describe(B()) + p.describe(C()), p.describe(D()), p.describe(E()), p.describe(F()), p.describe(B())
+)";
+        const auto remove_addresses = [](string output) {
+            for (size_t pos; (pos = output.find("0x")) != string::npos;) {
+                output.replace(pos, output.find_first_not_of("0123456789abcdef", pos + 2) - pos, "@");
+            }
+            return output;
+        };
+        ASSERT_EQUAL(remove_addresses(RunOnTreeWalker(program)), "k@m@m@ p@ p@ kz m@\n");
+        ASSERT_EQUAL(remove_addresses(RunOnVm(program)), "k@m@m@ p@ p@ kz m@\n");
+    }
+
+    void TestInitArgumentsAreEvaluatedWithInit() {
+        const string program = R"(
+class NoInit:
+  def get():
+    return 1
+
+class Noisy:
+  def value(x):
+    print 'value', x
+    return x
+
+n = Noisy()
+x = NoInit(n.value(5))
+print x.get(), n.value(6)
+)";
+        ASSERT_RUNS_AS_TREE(program, "1 value 6\n6\n");
+    }
+
+    void TestErrors() {
+        ASSERT_THROWS(RunOnVm("print x\n"), runtime_error);
+        ASSERT_THROWS(RunOnVm("print 1 + 'a'\n"), runtime_error);
+        ASSERT_THROWS(RunOnVm("class A:\n  def f():\n    return 1\nA().g()\n"), runtime_error);
+    }
+
+    void RunBytecodeTests(TestRunner &tr) {
+        RUN_TEST(tr, Bytecode::TestStatementValuesArePopped);
+        RUN_TEST(tr, Bytecode::TestMethodVariablesAreInSlots);
+        RUN_TEST(tr, Bytecode::TestMethodsDoNotSeeTopLevelVariables);
+        RUN_TEST(tr, Bytecode::TestMethodsAndInheritance);
+        RUN_TEST(tr, Bytecode::TestRecursion);
+        RUN_TEST(tr, Bytecode::TestReturns);
+        RUN_TEST(tr, Bytecode::TestEvaluationOrder);
+        RUN_TEST(tr, Bytecode::TestOperatorsOfInstances);
+        RUN_TEST(tr, Bytecode::TestComparisonsOfInstances);
+        RUN_TEST(tr, Bytecode::TestPolymorphicCallSites);
+        RUN_TEST(tr, Bytecode::TestInitArgumentsAreEvaluatedWithInit);
+        RUN_TEST(tr, Bytecode::TestErrors);
+    }
+
+} /* namespace Bytecode */
@@ -10,30 +10,68 @@ using namespace std;
 
 namespace Runtime {
 
-    bool Equal(ObjectHolder lhs, ObjectHolder rhs) {
-        if (auto num_ptr = lhs.TryAs<Number>(); num_ptr != nullptr) {
-            return num_ptr->GetValue() == rhs.TryAs<Number>()->GetValue();
+    namespace {
+        // Of the objects of the same kind only
+        template<template<typename> typename Compare>
+        bool CompareValues(const ObjectHolder &lhs, const ObjectHolder &rhs) {
+            const Object *lhs_ptr = lhs.Get(), *rhs_ptr = rhs.Get();
+            if (lhs_ptr != nullptr && rhs_ptr != nullptr && lhs_ptr->GetKind() == rhs_ptr->GetKind()) {
+                switch (lhs_ptr->GetKind()) {
+                    case ObjectKind::NUMBER:
+                        return Compare<int>()(static_cast<const Number *>(lhs_ptr)->GetValue(),
+                                              static_cast<const Number *>(rhs_ptr)->GetValue());
+                    case ObjectKind::BOOL:
+                        return Compare<bool>()(static_cast<const Bool *>(lhs_ptr)->GetValue(),
+                                               static_cast<const Bool *>(rhs_ptr)->GetValue());
+                    case ObjectKind::STRING:
+                        return Compare<string>()(static_cast<const String *>(lhs_ptr)->GetValue(),
+                                                 static_cast<const String *>(rhs_ptr)->GetValue());
+                    default:
+                        break;
+                }
+            }
+            throw runtime_error("comparators.cpp CompareValues [not comparable]");
         }
-        if (auto bool_ptr = lhs.TryAs<Bool>(); bool_ptr != nullptr) {
-            return bool_ptr->GetValue() == rhs.TryAs<Bool>()->GetValue();
-        }
-        if (auto str_ptr = lhs.TryAs<String>(); str_ptr != nullptr) {
-            return str_ptr->GetValue() == rhs.TryAs<String>()->GetValue();
+
+        bool CompareInstance(ObjectHolder lhs, const string &method, const ObjectHolder &rhs) {
+            auto instance = lhs.TryAs<ClassInstance>();
+            if (!instance->HasMethod(method, 1)) {
+                throw runtime_error("comparators.cpp CompareInstance [no " + method + "]");
+            }
+            return IsTrue(instance->Call(method, {rhs}));
         }
-        throw runtime_error("");
     }
 
-    bool Less(ObjectHolder lhs, ObjectHolder rhs) {
-        if (auto num_ptr = lhs.TryAs<Number>(); num_ptr != nullptr) {
-            return num_ptr->GetValue() < rhs.TryAs<Number>()->GetValue();
+    bool Equal(const ObjectHolder &lhs, const ObjectHolder &rhs) {
+        if (lhs.TryAs<ClassInstance>() != nullptr) {
+            return CompareInstance(lhs, "__eq__", rhs);
         }
-        if (auto bool_ptr = lhs.TryAs<Bool>(); bool_ptr != nullptr) {
-            return bool_ptr->GetValue() < rhs.TryAs<Bool>()->GetValue();
+        return CompareValues<equal_to>(lhs, rhs);
+    }
+
+    bool Less(const ObjectHolder &lhs, const ObjectHolder &rhs) {
+        if (lhs.TryAs<ClassInstance>() != nullptr) {
+            return CompareInstance(lhs, "__lt__", rhs);
         }
-        if (auto str_ptr = lhs.TryAs<String>(); str_ptr != nullptr) {
-            return str_ptr->GetValue() < rhs.TryAs<String>()->GetValue();
+        return CompareValues<less>(lhs, rhs);
+    }
+
+    ComparatorFunction GetComparator(ComparisonKind kind) {
+        switch (kind) {
+            case ComparisonKind::EQUAL:
+                return Equal;
+            case ComparisonKind::NOT_EQUAL:
+                return NotEqual;
+            case ComparisonKind::LESS:
+                return Less;
+            case ComparisonKind::GREATER:
+                return Greater;
+            case ComparisonKind::LESS_OR_EQUAL:
+                return LessOrEqual;
+            case ComparisonKind::GREATER_OR_EQUAL:
+                return GreaterOrEqual;
         }
-        throw runtime_error("");
+        throw invalid_argument("comparators.cpp GetComparator");
     }
 
 } /* namespace Runtime */
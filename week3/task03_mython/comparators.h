@@ -4,24 +4,59 @@
 
 namespace Runtime {
 
-    bool Equal(ObjectHolder lhs, ObjectHolder rhs);
+    // An instance is compared by its __eq__ and __lt__
+    bool Equal(const ObjectHolder &lhs, const ObjectHolder &rhs);
 
-    bool Less(ObjectHolder lhs, ObjectHolder rhs);
+    bool Less(const ObjectHolder &lhs, const ObjectHolder &rhs);
 
-    inline bool NotEqual(ObjectHolder lhs, ObjectHolder rhs) {
+    inline bool NotEqual(const ObjectHolder &lhs, const ObjectHolder &rhs) {
         return !Equal(lhs, rhs);
     }
 
-    inline bool Greater(ObjectHolder lhs, ObjectHolder rhs) {
+    inline bool Greater(const ObjectHolder &lhs, const ObjectHolder &rhs) {
         return !Less(lhs, rhs) && !Equal(lhs, rhs);
     }
 
-    inline bool LessOrEqual(ObjectHolder lhs, ObjectHolder rhs) {
+    inline bool LessOrEqual(const ObjectHolder &lhs, const ObjectHolder &rhs) {
         return !Greater(lhs, rhs);
     }
 
-    inline bool GreaterOrEqual(ObjectHolder lhs, ObjectHolder rhs) {
+    inline bool GreaterOrEqual(const ObjectHolder &lhs, const ObjectHolder &rhs) {
         return !Less(lhs, rhs);
     }
 
+    // Of the comparators above
+    enum class ComparisonKind {
+        EQUAL,
+        NOT_EQUAL,
+        LESS,
+        GREATER,
+        LESS_OR_EQUAL,
+        GREATER_OR_EQUAL,
+    };
+
+    using ComparatorFunction = bool (*)(const ObjectHolder &lhs, const ObjectHolder &rhs);
+
+    ComparatorFunction GetComparator(ComparisonKind kind);
+
+    // As the comparator of the kind, by the results of Equal and Less, which are called as the comparator calls them
+    template<typename EqualFunc, typename LessFunc>
+    bool Compare(ComparisonKind kind, EqualFunc equal, LessFunc less) {
+        switch (kind) {
+            case ComparisonKind::EQUAL:
+                return equal();
+            case ComparisonKind::NOT_EQUAL:
+                return !equal();
+            case ComparisonKind::LESS:
+                return less();
+            case ComparisonKind::GREATER:
+                return !less() && !equal();
+            case ComparisonKind::LESS_OR_EQUAL:
+                return less() || equal();
+            case ComparisonKind::GREATER_OR_EQUAL:
+                return !less();
+        }
+        return false;
+    }
+
 } /* namespace Runtime */
@@ -0,0 +1,44 @@
+#include "compiled_program.h"
+#include "lexer.h"
+#include "parse.h"
+
+using namespace std;
+
+namespace Runtime {
+
+    shared_ptr<const CompiledProgram> CompiledProgram::Compile(istream &input) {
+        Parse::Lexer lexer(input);
+        return make_shared<const CompiledProgram>(ParseProgram(lexer));
+    }
+
+    CompiledProgram::CompiledProgram(unique_ptr<Ast::Statement> tree)
+            : tree_(move(tree)), bytecode_(Bytecode::Compile(*tree_)) {}
+
+    Ast::Statement &CompiledProgram::GetTree() const {
+        return *tree_;
+    }
+
+    const Bytecode::Program &CompiledProgram::GetBytecode() const {
+        return bytecode_;
+    }
+
+    ExecutionContext::ExecutionContext(shared_ptr<const CompiledProgram> program, ostream &output, ExecutionEngine engine)
+            : program_(move(program)), output_(output), engine_(engine) {
+        if (engine_ == ExecutionEngine::BYTECODE_VM) {
+            vm_.emplace(program_->GetBytecode(), output_);
+        }
+    }
+
+    ObjectHolder ExecutionContext::Run() {
+        if (vm_) {
+            return vm_->Run(globals_);
+        }
+        Ast::Print::OutputScope printing(output_);
+        return program_->GetTree().Execute(globals_);
+    }
+
+    Closure &ExecutionContext::GetGlobals() {
+        return globals_;
+    }
+
+} /* namespace Runtime */
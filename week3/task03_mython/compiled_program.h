@@ -0,0 +1,67 @@
+#pragma once
+
+#include "bytecode.h"
+#include "object_holder.h"
+#include "statement.h"
+#include "vm.h"
+
+#include <istream>
+#include <memory>
+#include <optional>
+#include <ostream>
+
+class TestRunner;
+
+namespace Runtime {
+
+    enum class ExecutionEngine {
+        TREE_WALKER,  // Ast::Statement::Execute of the parsed program
+        BYTECODE_VM,  // the program compiled to bytecode
+    };
+
+    // A program parsed and compiled once, to be run many times. The runs change nothing of it, so it is shared
+    // by the contexts running it on any threads at once; the classes of the program are shared by them too
+    class CompiledProgram {
+    public:
+        static std::shared_ptr<const CompiledProgram> Compile(std::istream &input);
+
+        explicit CompiledProgram(std::unique_ptr<Ast::Statement> tree);
+
+        CompiledProgram(const CompiledProgram &) = delete;
+
+        CompiledProgram &operator=(const CompiledProgram &) = delete;
+
+        // Executing the tree does not change it, it is not const only for the interface of Ast::Statement
+        Ast::Statement &GetTree() const;
+
+        const Bytecode::Program &GetBytecode() const;
+
+    private:
+        std::unique_ptr<Ast::Statement> tree_;
+        Bytecode::Program bytecode_;  // points into the tree
+    };
+
+    // Of the runs of a compiled program on one thread at a time: the output, the top-level variables
+    // and the caches of the VM, which are kept warm from run to run
+    class ExecutionContext {
+    public:
+        ExecutionContext(std::shared_ptr<const CompiledProgram> program, std::ostream &output,
+                         ExecutionEngine engine = ExecutionEngine::BYTECODE_VM);
+
+        // Runs the program with the top-level variables as they are left by the previous run, returns its result
+        ObjectHolder Run();
+
+        // To set the inputs of the next run or to read the results of the last one
+        Closure &GetGlobals();
+
+    private:
+        std::shared_ptr<const CompiledProgram> program_;
+        std::ostream &output_;
+        ExecutionEngine engine_;
+        Closure globals_;
+        std::optional<Bytecode::VirtualMachine> vm_;
+    };
+
+    void RunCompiledProgramTests(TestRunner &tr);
+
+} /* namespace Runtime */
@@ -0,0 +1,107 @@
+#include "compiled_program.h"
+
+#include <test_runner.h>
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace Runtime {
+
+    namespace {
+        const ExecutionEngine ENGINES[] = {ExecutionEngine::TREE_WALKER, ExecutionEngine::BYTECODE_VM};
+
+        // Of the input n, set before a run
+        const string SUM_PROGRAM = R"(
+class Node:
+  def __init__(value):
+    self.value = value
+
+class Summer:
+  def sum(n):
+    if n < 1:
+      return 0
+    node = Node(n)
+    return node.value + self.sum(n - 1)
+
+  def __str__():
+    return 'summer'
+
+s = Summer()
+result = s.sum(n)
+print s, n, result
+)";
+
+        shared_ptr<const CompiledProgram> CompileString(const string &program) {
+            istringstream is(program);
+            return CompiledProgram::Compile(is);
+        }
+    }
+
+    void TestContextsRunProgramManyTimes() {
+        const auto program = CompileString(SUM_PROGRAM);
+        for (auto engine : ENGINES) {
+            ostringstream os;
+            ExecutionContext context(program, os, engine);
+            for (int n : {3, 10, 0}) {
+                context.GetGlobals()["n"] = ObjectHolder::Own(Number(n));
+                context.Run();
+            }
+            ASSERT_EQUAL(os.str(), "summer 3 6\nsummer 10 55\nsummer 0 0\n");
+            ASSERT_EQUAL(context.GetGlobals().at("result").TryAs<Number>()->GetValue(), 0);
+        }
+    }
+
+    void TestContextsRunAfterErrors() {
+        const auto program = CompileString(SUM_PROGRAM);
+        for (auto engine : ENGINES) {
+            ostringstream os;
+            ExecutionContext context(program, os, engine);
+            ASSERT_THROWS(context.Run(), runtime_error);
+            context.GetGlobals()["n"] = ObjectHolder::Own(Number(4));
+            context.Run();
+            ASSERT_EQUAL(os.str(), "summer 4 10\n");
+        }
+    }
+
+    void TestContextsRunOnThreadsAtOnce() {
+        const auto program = CompileString(SUM_PROGRAM);
+        for (auto engine : ENGINES) {
+            const int thread_count = 4;
+            const int runs = 50;
+            vector<ostringstream> outputs(thread_count);
+            vector<thread> threads;
+            for (int t = 0; t < thread_count; t++) {
+                threads.emplace_back([&, t] {
+                    ExecutionContext context(program, outputs[t], engine);
+                    for (int run = 0; run < runs; run++) {
+                        context.GetGlobals()["n"] = ObjectHolder::Own(Number(t * 10 + run % 5));
+                        context.Run();
+                    }
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+
+            for (int t = 0; t < thread_count; t++) {
+                ostringstream expected;
+                for (int run = 0; run < runs; run++) {
+                    const int n = t * 10 + run % 5;
+                    expected << "summer " << n << ' ' << n * (n + 1) / 2 << '\n';
+                }
+                ASSERT_EQUAL(outputs[t].str(), expected.str());
+            }
+        }
+    }
+
+    void RunCompiledProgramTests(TestRunner &tr) {
+        RUN_TEST(tr, Runtime::TestContextsRunProgramManyTimes);
+        RUN_TEST(tr, Runtime::TestContextsRunAfterErrors);
+        RUN_TEST(tr, Runtime::TestContextsRunOnThreadsAtOnce);
+    }
+
+} /* namespace Runtime */
@@ -1,12 +1,17 @@
 #include "object.h"
 #include "object_holder.h"
+#include "shape.h"
 #include "statement.h"
 #include "lexer.h"
 #include "parse.h"
+#include "bytecode.h"
+#include "profiler.h"
+#include "compiled_program.h"
 
 #include <test_runner.h>
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -18,26 +23,53 @@ using namespace std;
 
 void TestAll();
 
-void RunMythonProgram(istream &input, ostream &output) {
-    Ast::Print::SetOutputStream(output);
+using Runtime::ExecutionEngine;
 
-    Parse::Lexer lexer(input);
-    auto program = ParseProgram(lexer);
+const ExecutionEngine ALL_EXECUTION_ENGINES[] = {ExecutionEngine::TREE_WALKER, ExecutionEngine::BYTECODE_VM};
 
-    Runtime::Closure closure;
-    program->Execute(closure);
+void RunMythonProgram(istream &input, ostream &output, ExecutionEngine engine = ExecutionEngine::BYTECODE_VM) {
+    Runtime::ExecutionContext(Runtime::CompiledProgram::Compile(input), output, engine).Run();
 }
 
-int main() {
+// Usage: task03_mython [--tree-walker] [--profile <prefix>] < program
+// The profile is written to <prefix>.folded, the stacks for flamegraph.pl, and to <prefix>.json, the summary
+int main(int argc, const char *argv[]) {
     TestAll();
 
-    RunMythonProgram(cin, cout);
-
+    bool tree_walker = false;
+    optional<string> profile_prefix;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i] == "--tree-walker"s) {
+            tree_walker = true;
+        } else if (argv[i] == "--profile"s && i + 1 < argc) {
+            profile_prefix = argv[++i];
+        } else {
+            cerr << "Usage: " << argv[0] << " [--tree-walker] [--profile <prefix>] < program" << endl;
+            return 1;
+        }
+    }
+    const ExecutionEngine engine = tree_walker ? ExecutionEngine::TREE_WALKER : ExecutionEngine::BYTECODE_VM;
+
+    if (!profile_prefix) {
+        RunMythonProgram(cin, cout, engine);
+        return 0;
+    }
+
+    Runtime::Profiler profiler;
+    {
+        Runtime::Profiler::Scope profiling(profiler);
+        RunMythonProgram(cin, cout, engine);
+    }
+    ofstream folded(*profile_prefix + ".folded");
+    profiler.WriteFoldedStacks(folded);
+    ofstream json(*profile_prefix + ".json");
+    profiler.WriteJson(json);
     return 0;
 }
 
 void TestSimplePrints() {
-    istringstream input(R"(
+    for (auto engine : ALL_EXECUTION_ENGINES) {
+        istringstream input(R"(
 print 57
 print 10, 24, -8
 print 'hello'
@@ -47,14 +79,16 @@ print
 print None
 )");
 
-    ostringstream output;
-    RunMythonProgram(input, output);
+        ostringstream output;
+        RunMythonProgram(input, output, engine);
 
-    ASSERT_EQUAL(output.str(), "57\n10 24 -8\nhello\nworld\nTrue False\n\nNone\n");
+        ASSERT_EQUAL(output.str(), "57\n10 24 -8\nhello\nworld\nTrue False\n\nNone\n");
+    }
 }
 
 void TestAssignments() {
-    istringstream input(R"(
+    for (auto engine : ALL_EXECUTION_ENGINES) {
+        istringstream input(R"(
 x = 57
 print x
 x = 'C++ black belt'
@@ -66,25 +100,29 @@ x = None
 print x, y
 )");
 
-    ostringstream output;
-    RunMythonProgram(input, output);
+        ostringstream output;
+        RunMythonProgram(input, output, engine);
 
-    ASSERT_EQUAL(output.str(), "57\nC++ black belt\nFalse\nNone False\n");
+        ASSERT_EQUAL(output.str(), "57\nC++ black belt\nFalse\nNone False\n");
+    }
 }
 
 void TestArithmetics() {
-    istringstream input(
-            "print 1+2+3+4+5, 1*2*3*4*5, 1-2-3-4-5, 36/4/3, 2*5+10/2"
-    );
+    for (auto engine : ALL_EXECUTION_ENGINES) {
+        istringstream input(
+                "print 1+2+3+4+5, 1*2*3*4*5, 1-2-3-4-5, 36/4/3, 2*5+10/2"
+        );
 
-    ostringstream output;
-    RunMythonProgram(input, output);
+        ostringstream output;
+        RunMythonProgram(input, output, engine);
 
-    ASSERT_EQUAL(output.str(), "15 120 -13 3 15\n");
+        ASSERT_EQUAL(output.str(), "15 120 -13 3 15\n");
+    }
 }
 
 void TestVariablesArePointers() {
-    istringstream input(R"(
+    for (auto engine : ALL_EXECUTION_ENGINES) {
+        istringstream input(R"(
 class Counter:
   def __init__():
     self.value = 0
@@ -110,19 +148,24 @@ d.do_add(x)
 print y.value
 )");
 
-    ostringstream output;
-    RunMythonProgram(input, output);
+        ostringstream output;
+        RunMythonProgram(input, output, engine);
 
-    ASSERT_EQUAL(output.str(), "2\n3\n");
+        ASSERT_EQUAL(output.str(), "2\n3\n");
+    }
 }
 
 void TestAll() {
     TestRunner tr;
     Runtime::RunObjectHolderTests(tr);
     Runtime::RunObjectsTests(tr);
+    Runtime::RunShapeTests(tr);
+    Runtime::RunProfilerTests(tr);
+    Runtime::RunCompiledProgramTests(tr);
     Ast::RunUnitTests(tr);
     Parse::RunLexerTests(tr);
     TestParseProgram(tr);
+    Bytecode::RunBytecodeTests(tr);
 
     RUN_TEST(tr, TestSimplePrints);
     RUN_TEST(tr, TestAssignments);
@@ -0,0 +1,302 @@
+#include "bytecode.h"
+#include "lexer.h"
+#include "parse.h"
+#include "statement.h"
+#include "vm.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <optional>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Usage: mython_benchmark [--runs <count>] [--baseline <file>] [--save-baseline <file>] [program.my...]
+// Runs every program (by default of the corpus in benchmarks/) on the tree walker and on the bytecode VM, checks that
+// they print the same, and prints the median time of lexing, parsing (the lexing it does included), compiling and
+// execution over the runs with the allocations of a run. The times and allocations are compared with the baseline,
+// benchmarks/baseline.txt by default, which --save-baseline writes.
+
+namespace {
+    size_t allocation_count = 0;
+}
+
+void *operator new(size_t size) {
+    allocation_count++;
+    if (void *ptr = malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    free(ptr);
+}
+
+namespace {
+    using Clock = chrono::steady_clock;
+
+    // Output of the timed runs, formatted but not kept
+    class NullBuffer : public streambuf {
+    protected:
+        int overflow(int c) override {
+            return c;
+        }
+
+        streamsize xsputn(const char *, streamsize count) override {
+            return count;
+        }
+    };
+
+    enum class Phase {
+        LEX,
+        PARSE,
+        COMPILE,
+        EXECUTE,
+    };
+
+    const Phase ALL_PHASES[] = {Phase::LEX, Phase::PARSE, Phase::COMPILE, Phase::EXECUTE};
+
+    struct Measurement {
+        int64_t microseconds = 0;
+        size_t allocations = 0;
+    };
+
+    // By phases, the compiling is of the VM only
+    using Measurements = map<Phase, Measurement>;
+
+    struct Engine {
+        string name;
+        bool compiled;
+    };
+
+    const Engine ENGINES[] = {{"tree", false}, {"vm", true}};
+
+    template<typename Func>
+    Measurement Measure(Func func) {
+        const size_t allocations_before = allocation_count;
+        const auto start = Clock::now();
+        func();
+        const auto finish = Clock::now();
+        return {chrono::duration_cast<chrono::microseconds>(finish - start).count(), allocation_count - allocations_before};
+    }
+
+    unique_ptr<Ast::Statement> Parse(const string &source) {
+        istringstream input(source);
+        Parse::Lexer lexer(input);
+        return ParseProgram(lexer);
+    }
+
+    void Execute(Ast::Statement &tree, const Bytecode::Program *bytecode, ostream &output) {
+        Runtime::Closure closure;
+        if (bytecode != nullptr) {
+            Bytecode::VirtualMachine(*bytecode, output).Run(closure);
+        } else {
+            Ast::Print::OutputScope printing(output);
+            tree.Execute(closure);
+        }
+    }
+
+    string RunOnce(const string &source, const Engine &engine) {
+        auto tree = Parse(source);
+        optional<Bytecode::Program> bytecode;
+        if (engine.compiled) {
+            bytecode = Bytecode::Compile(*tree);
+        }
+        ostringstream output;
+        Execute(*tree, bytecode ? &*bytecode : nullptr, output);
+        return output.str();
+    }
+
+    Measurements RunMeasured(const string &source, const Engine &engine) {
+        Measurements result;
+        result[Phase::LEX] = Measure([&] {
+            istringstream input(source);
+            Parse::Lexer lexer(input);
+            while (!lexer.CurrentToken().Is<Parse::TokenType::Eof>()) {
+                lexer.NextToken();
+            }
+        });
+
+        unique_ptr<Ast::Statement> tree;
+        result[Phase::PARSE] = Measure([&] { tree = Parse(source); });
+
+        optional<Bytecode::Program> bytecode;
+        if (engine.compiled) {
+            result[Phase::COMPILE] = Measure([&] { bytecode = Bytecode::Compile(*tree); });
+        }
+
+        NullBuffer null_buffer;
+        ostream null_output(&null_buffer);
+        result[Phase::EXECUTE] = Measure([&] { Execute(*tree, bytecode ? &*bytecode : nullptr, null_output); });
+        return result;
+    }
+
+    // Of the time, the allocations are the same in every run
+    Measurements Median(const vector<Measurements> &runs) {
+        Measurements result = runs.front();
+        for (auto &[phase, measurement] : result) {
+            vector<int64_t> times;
+            for (const auto &run : runs) {
+                times.push_back(run.at(phase).microseconds);
+            }
+            nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+            measurement.microseconds = times[times.size() / 2];
+        }
+        return result;
+    }
+
+    // A line per program and engine: the program, the engine and the microseconds and the allocations of every phase
+    using Baseline = map<pair<string, string>, Measurements>;
+
+    Baseline ReadBaseline(const string &path) {
+        Baseline baseline;
+        ifstream input(path);
+        string program, engine;
+        while (input >> program >> engine) {
+            auto &measurements = baseline[{program, engine}];
+            for (Phase phase : ALL_PHASES) {
+                input >> measurements[phase].microseconds >> measurements[phase].allocations;
+            }
+        }
+        return baseline;
+    }
+
+    void WriteBaseline(const string &path, const Baseline &baseline) {
+        ofstream output(path);
+        for (const auto &[key, measurements] : baseline) {
+            output << key.first << ' ' << key.second;
+            for (Phase phase : ALL_PHASES) {
+                auto it = measurements.find(phase);
+                const Measurement measurement = it != measurements.end() ? it->second : Measurement{};
+                output << ' ' << measurement.microseconds << ' ' << measurement.allocations;
+            }
+            output << '\n';
+        }
+    }
+
+    string FormatRatio(double current, double baseline) {
+        if (baseline == 0) {
+            return "-";
+        }
+        ostringstream os;
+        os << fixed << setprecision(2) << current / baseline << 'x';
+        return os.str();
+    }
+
+    string ReadFile(const string &path) {
+        ifstream input(path);
+        return string(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+    }
+}
+
+int main(int argc, const char *argv[]) {
+    int runs = 5;
+    string baseline_path = string(MYTHON_BENCHMARKS_DIR) + "/baseline.txt";
+    optional<string> save_baseline_path;
+    vector<string> programs;
+    for (int i = 1; i < argc; i++) {
+        const string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc) {
+            runs = max(1, atoi(argv[++i]));
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (arg == "--save-baseline" && i + 1 < argc) {
+            save_baseline_path = argv[++i];
+        } else {
+            programs.push_back(arg);
+        }
+    }
+    if (programs.empty()) {
+        for (const auto &entry : filesystem::directory_iterator(MYTHON_BENCHMARKS_DIR)) {
+            if (entry.path().extension() == ".my") {
+                programs.push_back(entry.path().string());
+            }
+        }
+        sort(programs.begin(), programs.end());
+    }
+
+    const Baseline baseline = ReadBaseline(baseline_path);
+    Baseline results;
+
+    cout << left << setw(18) << "program" << setw(6) << "engine" << right
+         << setw(10) << "lex us" << setw(10) << "parse us" << setw(12) << "compile us" << setw(10) << "exec us"
+         << setw(10) << "allocs" << setw(12) << "exec/base" << setw(13) << "allocs/base" << '\n';
+    bool outputs_match = true;
+    for (const string &path : programs) {
+        const string source = ReadFile(path);
+        const string name = filesystem::path(path).filename().string();
+
+        optional<string> expected_output;
+        for (const Engine &engine : ENGINES) {
+            const string output = RunOnce(source, engine);
+            if (expected_output && output != *expected_output) {
+                cerr << name << ": the output on " << engine.name << " differs from the one on " << ENGINES[0].name << endl;
+                outputs_match = false;
+            }
+            expected_output = output;
+
+            vector<Measurements> measured_runs;
+            for (int run = 0; run < runs; run++) {
+                measured_runs.push_back(RunMeasured(source, engine));
+            }
+            const Measurements median = Median(measured_runs);
+            results[{name, engine.name}] = median;
+
+            size_t allocations = 0;
+            for (const auto &[phase, measurement] : median) {
+                allocations += measurement.allocations;
+            }
+            const auto get = [](const Measurements &measurements, Phase phase) {
+                auto it = measurements.find(phase);
+                return it != measurements.end() ? it->second : Measurement{};
+            };
+            cout << left << setw(18) << name << setw(6) << engine.name << right
+                 << setw(10) << get(median, Phase::LEX).microseconds
+                 << setw(10) << get(median, Phase::PARSE).microseconds
+                 << setw(12) << (engine.compiled ? to_string(get(median, Phase::COMPILE).microseconds) : "-")
+                 << setw(10) << get(median, Phase::EXECUTE).microseconds
+                 << setw(10) << allocations;
+            if (auto it = baseline.find({name, engine.name}); it != baseline.end()) {
+                size_t baseline_allocations = 0;
+                for (const auto &[phase, measurement] : it->second) {
+                    baseline_allocations += measurement.allocations;
+                }
+                cout << setw(12) << FormatRatio(get(median, Phase::EXECUTE).microseconds, get(it->second, Phase::EXECUTE).microseconds)
+                     << setw(13) << FormatRatio(allocations, baseline_allocations);
+            }
+            cout << '\n';
+        }
+    }
+
+    if (save_baseline_path) {
+        WriteBaseline(*save_baseline_path, results);
+    }
+    return outputs_match ? 0 : 1;
+}
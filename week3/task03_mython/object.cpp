@@ -1,5 +1,6 @@
 #include "object.h"
 #include "statement.h"
+#include "profiler.h"
 
 #include <sstream>
 #include <string_view>
@@ -19,19 +20,64 @@ namespace Runtime {
     }
 
     bool ClassInstance::HasMethod(const std::string &method, size_t argument_count) const {
+        return FindMethod(method, argument_count) != nullptr;
+    }
+
+    const Method *ClassInstance::FindMethod(const std::string &method, size_t argument_count) const {
         auto method_ptr = cls_.GetMethod(method);
-        return method_ptr && method_ptr->formal_params.size() == argument_count;
+        if (method_ptr && method_ptr->formal_params.size() == argument_count) {
+            return method_ptr;
+        }
+        return nullptr;
     }
 
-    const Closure &ClassInstance::Fields() const {
-        return fields_;
+    ConstFieldsView ClassInstance::Fields() const {
+        return ConstFieldsView(*this);
+    }
+
+    FieldsView ClassInstance::Fields() {
+        return FieldsView(*this);
+    }
+
+    const Shape &ClassInstance::GetShape() const {
+        return *shape_;
+    }
+
+    ObjectHolder &ClassInstance::GetField(size_t offset) {
+        return field_values_[offset];
+    }
+
+    const ObjectHolder &ClassInstance::GetField(size_t offset) const {
+        return field_values_[offset];
+    }
+
+    void ClassInstance::AddField(const Shape &shape, ObjectHolder value) {
+        shape_ = &shape;
+        field_values_.push_back(move(value));
+    }
+
+    ClassInstance::ClassInstance(const Class &cls) : Object(KIND), cls_(cls), shape_(&cls.GetEmptyShape()) {}
+
+    ClassInstance::ClassInstance(const ClassInstance &other)
+            : Object(KIND), cls_(other.cls_), shape_(other.shape_), field_values_(other.field_values_) {}
+
+    ClassInstance::ClassInstance(ClassInstance &&other) noexcept
+            : Object(KIND), cls_(other.cls_), shape_(other.shape_), field_values_(move(other.field_values_)),
+              profiler_(exchange(other.profiler_, nullptr)) {}
+
+    ClassInstance::~ClassInstance() {
+        if (profiler_ != nullptr) {
+            profiler_->OnInstanceDestroyed();
+        }
     }
 
-    Closure &ClassInstance::Fields() {
-        return fields_;
+    void ClassInstance::SetProfiled(Profiler &profiler) {
+        profiler_ = &profiler;
     }
 
-    ClassInstance::ClassInstance(const Class &cls) : cls_(cls) {}
+    const Class &ClassInstance::GetClass() const {
+        return cls_;
+    }
 
     Closure CreateArgsClosure(const std::vector<string> &param_names, ObjectHolder self, const std::vector<ObjectHolder> &actual_args) {
         Closure res;
@@ -43,39 +89,57 @@ namespace Runtime {
     }
 
     ObjectHolder ClassInstance::Call(const std::string &method, const std::vector<ObjectHolder> &actual_args) {
-        if (!HasMethod(method, actual_args.size())) {
+        auto method_ptr = FindMethod(method, actual_args.size());
+        if (method_ptr == nullptr) {
             throw runtime_error("ObjectHolder ClassInstance::Call " + method);
         }
+        Profiler::MethodCall profiled_call(Profiler::Current(), *this, method);
 
         Closure actual_args_closure = CreateArgsClosure(
-                this->cls_.GetMethod(method)->formal_params,
+                method_ptr->formal_params,
                 ObjectHolder::Share(*this),
                 actual_args
         );
-        return this->cls_.GetMethod(method)->body->Execute(actual_args_closure);
+        return method_ptr->body->Execute(actual_args_closure);
     }
 
-    Class::Class(std::string name, std::vector<Method> methods, const Class *parent) : name_(move(name)), parent_(parent) {
+    Class::Class(std::string name, std::vector<Method> methods, const Class *parent, shared_ptr<const Shape> empty_shape)
+            : Object(KIND), name_(move(name)), parent_(parent), empty_shape_(move(empty_shape)) {
+        if (!empty_shape_) {
+            empty_shape_ = parent_ != nullptr ? parent_->empty_shape_ : Shape::MakeEmpty();
+        }
         for (auto &method : methods) {
             auto it = methods_.insert({method.name, move(method)});
             if (it.first->first != it.first->second.name) {
                 throw runtime_error("assert Class::Class");  // todo
             }
         }
+
+        // The nodes of methods_ are kept when the class is moved, so are the pointers to them
+        if (parent_ != nullptr) {
+            method_table_ = parent_->method_table_;
+        }
+        for (const auto &[method_name, method] : methods_) {
+            method_table_[method_name] = &method;
+        }
     }
 
     const Method *Class::GetMethod(const std::string &name) const {
-        auto it = methods_.find(name);
-        if (it != methods_.end()) {
-            return &it->second;
+        auto it = method_table_.find(name);
+        if (it != method_table_.end()) {
+            return it->second;
         }
-        if (parent_ != nullptr) {
-            return parent_->GetMethod(name);
-        }
-        // else
         return nullptr;
     }
 
+    const std::unordered_map<std::string, Method> &Class::GetOwnMethods() const {
+        return methods_;
+    }
+
+    const Class *Class::GetParent() const {
+        return parent_;
+    }
+
     void Class::Print(ostream &os) {
         os << GetName() << " class at address " << this;
     }
@@ -84,6 +148,10 @@ namespace Runtime {
         return name_;
     }
 
+    const Shape &Class::GetEmptyShape() const {
+        return *empty_shape_;
+    }
+
     void Bool::Print(std::ostream &os) {
         if (GetValue()) {
             os << "True";
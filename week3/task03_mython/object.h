@@ -1,12 +1,16 @@
 #pragma once
 
 #include "object_holder.h"
+#include "shape.h"
 
 #include <ostream>
 #include <string>
 #include <vector>
 #include <memory>
+#include <stdexcept>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 
 namespace Ast {
     class Statement;
@@ -16,46 +20,7 @@ class TestRunner;
 
 namespace Runtime {
 
-    class Object {
-    public:
-        virtual ~Object() = default;
-
-        virtual void Print(std::ostream &os) = 0;
-    };
-
-    class NoneObject : public Object {
-        void Print(std::ostream &os) override {
-            os << "None";
-        }
-    };
-
-    template<typename T>
-    class ValueObject : public Object {
-    public:
-        ValueObject(T v) : value(v) {
-        }
-
-        void Print(std::ostream &os) override {
-            os << value;
-        }
-
-        const T &GetValue() const {
-            return value;
-        }
-
-    private:
-        T value;
-    };
-
-    using String = ValueObject<std::string>;
-    using Number = ValueObject<int>;
-
-    class Bool : public ValueObject<bool> {
-    public:
-        using ValueObject<bool>::ValueObject;
-
-        void Print(std::ostream &os) override;
-    };
+    class Profiler;
 
     struct Method {
         std::string name;
@@ -65,37 +30,183 @@ namespace Runtime {
 
     class Class : public Object {
     public:
-        explicit Class(std::string name, std::vector<Method> methods, const Class *parent);
+        static constexpr ObjectKind KIND = ObjectKind::CLASS;
+
+        // The instances start from the empty shape, shared by the classes of a program; of the parent, if it is null
+        explicit Class(std::string name, std::vector<Method> methods, const Class *parent,
+                       std::shared_ptr<const Shape> empty_shape = nullptr);
 
+        // The method table points into the methods of the class and of its bases, so a class is moved, not copied
+        Class(const Class &) = delete;
+
+        Class(Class &&) = default;
+
+        // Own or inherited, one lookup in the method table
         const Method *GetMethod(const std::string &name) const;
 
+        // Methods defined in the class itself, without the inherited ones
+        const std::unordered_map<std::string, Method> &GetOwnMethods() const;
+
+        const Class *GetParent() const;
+
         const std::string &GetName() const;
 
+        const Shape &GetEmptyShape() const;
+
         void Print(std::ostream &os) override;
 
     private:
         std::string name_;
         std::unordered_map<std::string, Method> methods_;
         const Class* parent_;
+        std::unordered_map<std::string, const Method *> method_table_;  // with the inherited methods
+        std::shared_ptr<const Shape> empty_shape_;
     };
 
+    class ClassInstance;
+
+    template<typename Instance>
+    class BasicFieldsView;
+
+    using FieldsView = BasicFieldsView<ClassInstance>;
+    using ConstFieldsView = BasicFieldsView<const ClassInstance>;
+
+    // The fields are laid out by the shape of the instance: the shape changes when a field is added
     class ClassInstance : public Object {
     public:
+        static constexpr ObjectKind KIND = ObjectKind::CLASS_INSTANCE;
+
         explicit ClassInstance(const Class &cls);
 
+        // Only the instance counted by the profiler is uncounted when destroyed, not its copies or the moved-from one
+        ClassInstance(const ClassInstance &other);
+
+        ClassInstance(ClassInstance &&other) noexcept;
+
+        ~ClassInstance() override;
+
         void Print(std::ostream &os) override;
 
         ObjectHolder Call(const std::string &method, const std::vector<ObjectHolder> &actual_args);
 
         bool HasMethod(const std::string &method, size_t argument_count) const;
 
-        Closure &Fields();
+        // nullptr if the class has no such method of the argument count
+        const Method *FindMethod(const std::string &method, size_t argument_count) const;
+
+        const Class &GetClass() const;
 
-        const Closure &Fields() const;
+        FieldsView Fields();
+
+        ConstFieldsView Fields() const;
+
+        const Shape &GetShape() const;
+
+        // At the offset of the field in the shape of the instance
+        ObjectHolder &GetField(size_t offset);
+
+        const ObjectHolder &GetField(size_t offset) const;
+
+        // The shape must be GetShape().AddField of the name of the field
+        void AddField(const Shape &shape, ObjectHolder value);
+
+        // Counted as a live instance by the profiler until it is destroyed
+        void SetProfiled(Profiler &profiler);
 
     private:
         const Class& cls_;
-        Closure fields_;
+        const Shape *shape_;
+        std::vector<ObjectHolder> field_values_;
+        Profiler *profiler_ = nullptr;  // that counts the instance, nullptr if none does
+    };
+
+    // Fields of a class instance by names, with the lookup interface of a Closure
+    template<typename Instance>
+    class BasicFieldsView {
+    public:
+        using Value = std::conditional_t<std::is_const_v<Instance>, const ObjectHolder, ObjectHolder>;
+        using Item = std::pair<const std::string &, Value &>;
+
+        class Iterator {
+        public:
+            Iterator(Instance *instance, size_t offset) : instance_(instance), offset_(offset) {}
+
+            Item operator*() const {
+                return {instance_->GetShape().GetFieldName(offset_), instance_->GetField(offset_)};
+            }
+
+            struct Arrow {
+                Item item;
+
+                Item *operator->() { return &item; }
+            };
+
+            Arrow operator->() const {
+                return {**this};
+            }
+
+            Iterator &operator++() {
+                ++offset_;
+                return *this;
+            }
+
+            bool operator==(const Iterator &other) const {
+                return instance_ == other.instance_ && offset_ == other.offset_;
+            }
+
+            bool operator!=(const Iterator &other) const {
+                return !(*this == other);
+            }
+
+        private:
+            Instance *instance_;
+            size_t offset_;
+        };
+
+        explicit BasicFieldsView(Instance &instance) : instance_(&instance) {}
+
+        Iterator begin() const {
+            return {instance_, 0};
+        }
+
+        Iterator end() const {
+            return {instance_, size()};
+        }
+
+        Iterator find(const std::string &name) const {
+            auto offset = instance_->GetShape().FindField(name);
+            return {instance_, offset ? *offset : size()};
+        }
+
+        size_t size() const {
+            return instance_->GetShape().GetFieldCount();
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        Value &at(const std::string &name) const {
+            auto offset = instance_->GetShape().FindField(name);
+            if (!offset) {
+                throw std::out_of_range("no field " + name);
+            }
+            return instance_->GetField(*offset);
+        }
+
+        // Adds the field if there is no such one
+        template<typename I = Instance, typename = std::enable_if_t<!std::is_const_v<I>>>
+        ObjectHolder &operator[](const std::string &name) const {
+            const Shape &shape = instance_->GetShape();
+            if (auto offset = shape.FindField(name)) {
+                return instance_->GetField(*offset);
+            }
+            instance_->AddField(shape.AddField(name), ObjectHolder());
+            return instance_->GetField(shape.GetFieldCount());
+        }
+
+    private:
+        Instance *instance_;
     };
 
     void RunObjectsTests(TestRunner &test_runner);
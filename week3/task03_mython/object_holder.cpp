@@ -13,51 +13,23 @@ namespace Runtime {
         return ObjectHolder::Own(NoneObject());
     }
 
-    Object &ObjectHolder::operator*() {
-        return *Get();
-    }
-
-    const Object &ObjectHolder::operator*() const {
-        return *Get();
-    }
-
-    Object *ObjectHolder::operator->() {
-        return Get();
-    }
-
-    const Object *ObjectHolder::operator->() const {
-        return Get();
-    }
-
-    Object *ObjectHolder::Get() {
-        return data.get();
-    }
-
-    const Object *ObjectHolder::Get() const {
-        return data.get();
-    }
-
-    ObjectHolder::operator bool() const {
-        return Get() && TryAs<Runtime::NoneObject>() == nullptr;
-    }
-
-    bool IsTrue(ObjectHolder object) {
-        if (!object.Get()) {
+    bool IsTrue(const ObjectHolder &object) {
+        const Object *value = object.Get();
+        if (!value) {
             return false;
         }
-        if (auto num = object.TryAs<Number>(); num != nullptr) {
-            return num->GetValue();
-        }
-        if (auto b = object.TryAs<Bool>(); b != nullptr) {
-            return b->GetValue();
-        }
-        if (auto str = object.TryAs<String>(); str != nullptr) {
-            return !str->GetValue().empty();
-        }
-        if (auto str = object.TryAs<NoneObject>(); str != nullptr) {
-            return false;
+        switch (value->GetKind()) {
+            case ObjectKind::NUMBER:
+                return static_cast<const Number *>(value)->GetValue();
+            case ObjectKind::BOOL:
+                return static_cast<const Bool *>(value)->GetValue();
+            case ObjectKind::STRING:
+                return !static_cast<const String *>(value)->GetValue().empty();
+            case ObjectKind::NONE:
+                return false;
+            default:
+                throw std::runtime_error("object_holder.cpp IsTrue");
         }
-        throw std::runtime_error("object_holder.cpp IsTrue");
     }
 
 }
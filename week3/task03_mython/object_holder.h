@@ -1,62 +1,301 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <new>
+#include <ostream>
+#include <string>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 
 class TestRunner;
 
 namespace Runtime {
 
-    class Object;
+    // The objects of a kind other than OTHER are of the one class with the KIND
+    enum class ObjectKind : uint8_t {
+        OTHER,
+        NONE,
+        NUMBER,
+        STRING,
+        BOOL,
+        CLASS,
+        CLASS_INSTANCE,
+    };
+
+    class Object {
+    public:
+        explicit Object(ObjectKind kind = ObjectKind::OTHER) : kind_(kind) {}
+
+        virtual ~Object() = default;
+
+        virtual void Print(std::ostream &os) = 0;
+
+        ObjectKind GetKind() const {
+            return kind_;
+        }
+
+    private:
+        ObjectKind kind_;
+    };
+
+    class NoneObject : public Object {
+    public:
+        static constexpr ObjectKind KIND = ObjectKind::NONE;
+
+        NoneObject() : Object(KIND) {}
+
+    private:
+        void Print(std::ostream &os) override {
+            os << "None";
+        }
+    };
+
+    template<typename T>
+    constexpr ObjectKind VALUE_OBJECT_KIND = ObjectKind::OTHER;
+
+    template<>
+    constexpr ObjectKind VALUE_OBJECT_KIND<int> = ObjectKind::NUMBER;
+
+    template<>
+    constexpr ObjectKind VALUE_OBJECT_KIND<std::string> = ObjectKind::STRING;
+
+    template<>
+    constexpr ObjectKind VALUE_OBJECT_KIND<bool> = ObjectKind::BOOL;
+
+    template<typename T>
+    class ValueObject : public Object {
+    public:
+        static constexpr ObjectKind KIND = VALUE_OBJECT_KIND<T>;
+
+        ValueObject(T v) : Object(KIND), value(v) {
+        }
+
+        void Print(std::ostream &os) override {
+            os << value;
+        }
+
+        const T &GetValue() const {
+            return value;
+        }
+
+    private:
+        T value;
+    };
+
+    using String = ValueObject<std::string>;
+    using Number = ValueObject<int>;
 
+    class Bool : public ValueObject<bool> {
+    public:
+        using ValueObject<bool>::ValueObject;
+
+        void Print(std::ostream &os) override;
+    };
+
+    // Of the classes with a KIND, not to be derived from
+    template<typename T, typename = void>
+    constexpr bool HAS_KIND = false;
+
+    template<typename T>
+    constexpr bool HAS_KIND<T, std::void_t<decltype(T::KIND)>> = true;
+
+    // Numbers, bools and None are kept in the holder itself, without a heap allocation;
+    // an owned copy of them is as good as a shared one, since they are never changed
     class ObjectHolder {
     public:
-        ObjectHolder() = default;
+        template<typename T>
+        static constexpr bool IS_STORED_INLINE = std::is_same_v<T, Number> || std::is_same_v<T, Bool> || std::is_same_v<T, NoneObject>;
+
+        ObjectHolder() {}
+
+        ObjectHolder(const ObjectHolder &other) {
+            CopyFrom(other);
+        }
+
+        ObjectHolder(ObjectHolder &&other) noexcept {
+            MoveFrom(other);
+        }
+
+        ObjectHolder &operator=(const ObjectHolder &other) {
+            if (this != &other) {
+                // Released after the other is copied, the object held here may own it
+                ObjectHolder old(std::move(*this));
+                CopyFrom(other);
+            }
+            return *this;
+        }
+
+        ObjectHolder &operator=(ObjectHolder &&other) noexcept {
+            if (this != &other) {
+                // Released after the other is taken, the object held here may own it
+                ObjectHolder old(std::move(*this));
+                MoveFrom(other);
+            }
+            return *this;
+        }
+
+        ~ObjectHolder() {
+            Reset();
+        }
 
         template<typename T>
         static ObjectHolder Own(T &&object) {
-            return ObjectHolder(
-                    std::make_shared<T>(std::forward<T>(object))
-            );
+            using Type = std::decay_t<T>;
+            ObjectHolder result;
+            if constexpr (std::is_same_v<Type, Number>) {
+                new(&result.number_) Number(std::forward<T>(object));
+                result.storage_ = Storage::NUMBER;
+            } else if constexpr (std::is_same_v<Type, Bool>) {
+                new(&result.bool_) Bool(std::forward<T>(object));
+                result.storage_ = Storage::BOOL;
+            } else if constexpr (std::is_same_v<Type, NoneObject>) {
+                new(&result.none_) NoneObject(std::forward<T>(object));
+                result.storage_ = Storage::NONE;
+            } else {
+                new(&result.data_) std::shared_ptr<Object>(std::make_shared<Type>(std::forward<T>(object)));
+                result.storage_ = Storage::SHARED;
+            }
+            return result;
         }
 
         static ObjectHolder Share(Object &object);
 
         static ObjectHolder None();
 
-        Object &operator*();
+        Object &operator*() {
+            return *Get();
+        }
 
-        const Object &operator*() const;
+        const Object &operator*() const {
+            return *Get();
+        }
 
-        Object *operator->();
+        Object *operator->() {
+            return Get();
+        }
 
-        const Object *operator->() const;
+        const Object *operator->() const {
+            return Get();
+        }
 
-        Object *Get();
+        Object *Get() {
+            return const_cast<Object *>(std::as_const(*this).Get());
+        }
 
-        const Object *Get() const;
+        const Object *Get() const {
+            switch (storage_) {
+                case Storage::SHARED:
+                    return data_.get();
+                case Storage::NUMBER:
+                    return &number_;
+                case Storage::BOOL:
+                    return &bool_;
+                case Storage::NONE:
+                    return &none_;
+                default:
+                    return nullptr;
+            }
+        }
 
+        // Checks the kind of the object instead of dynamic_cast for the classes with a KIND
         template<typename T>
         T *TryAs() {
-            return dynamic_cast<T *>(this->Get());
+            return const_cast<T *>(std::as_const(*this).TryAs<T>());
         }
 
         template<typename T>
         const T *TryAs() const {
-            return dynamic_cast<const T *>(this->Get());
+            if constexpr (HAS_KIND<T>) {
+                const Object *object = Get();
+                return object != nullptr && object->GetKind() == T::KIND ? static_cast<const T *>(object) : nullptr;
+            } else {
+                return dynamic_cast<const T *>(this->Get());
+            }
         }
 
-        explicit operator bool() const;
+        explicit operator bool() const {
+            const Object *object = Get();
+            return object != nullptr && object->GetKind() != ObjectKind::NONE;
+        }
 
     private:
-        ObjectHolder(std::shared_ptr<Object> data) : data(std::move(data)) {}
+        enum class Storage : uint8_t {
+            EMPTY,
+            SHARED,
+            NUMBER,
+            BOOL,
+            NONE,
+        };
+
+        explicit ObjectHolder(std::shared_ptr<Object> data) : storage_(Storage::SHARED) {
+            new(&data_) std::shared_ptr<Object>(std::move(data));
+        }
+
+        // Both are for an empty holder
+        void CopyFrom(const ObjectHolder &other) {
+            switch (other.storage_) {
+                case Storage::SHARED:
+                    new(&data_) std::shared_ptr<Object>(other.data_);
+                    break;
+                case Storage::NUMBER:
+                    new(&number_) Number(other.number_);
+                    break;
+                case Storage::BOOL:
+                    new(&bool_) Bool(other.bool_);
+                    break;
+                case Storage::NONE:
+                    new(&none_) NoneObject(other.none_);
+                    break;
+                case Storage::EMPTY:
+                    break;
+            }
+            storage_ = other.storage_;
+        }
+
+        void MoveFrom(ObjectHolder &other) {
+            if (other.storage_ == Storage::SHARED) {
+                new(&data_) std::shared_ptr<Object>(std::move(other.data_));
+                storage_ = Storage::SHARED;
+            } else {
+                CopyFrom(other);
+            }
+            other.Reset();
+        }
+
+        void Reset() {
+            switch (storage_) {
+                case Storage::SHARED:
+                    data_.~shared_ptr();
+                    break;
+                case Storage::NUMBER:
+                    number_.~Number();
+                    break;
+                case Storage::BOOL:
+                    bool_.~Bool();
+                    break;
+                case Storage::NONE:
+                    none_.~NoneObject();
+                    break;
+                case Storage::EMPTY:
+                    break;
+            }
+            storage_ = Storage::EMPTY;
+        }
 
-        std::shared_ptr<Object> data;
+        Storage storage_ = Storage::EMPTY;
+        union {
+            std::shared_ptr<Object> data_;
+            Number number_;
+            Bool bool_;
+            NoneObject none_;
+        };
     };
 
     using Closure = std::unordered_map<std::string, ObjectHolder>;
 
-    bool IsTrue(ObjectHolder object);
+    bool IsTrue(const ObjectHolder &object);
 
     void RunObjectHolderTests(TestRunner &tr);
 
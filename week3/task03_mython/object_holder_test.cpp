@@ -17,11 +17,11 @@ namespace Runtime {
             ++instance_count;
         }
 
-        Logger(const Logger &rhs) : id(rhs.id) {
+        Logger(const Logger &rhs) : Object(rhs), id(rhs.id) {
             ++instance_count;
         }
 
-        Logger(Logger &&rhs) : id(rhs.id) {
+        Logger(Logger &&rhs) : Object(rhs), id(rhs.id) {
             ++instance_count;
         }
 
@@ -108,11 +108,51 @@ namespace Runtime {
         ASSERT(!oh.Get());
     }
 
+    void TestInlineValues() {
+        auto number = ObjectHolder::Own(Number(42));
+        auto copy = number;
+        ASSERT(copy.Get() != number.Get());
+        ASSERT_EQUAL(copy.TryAs<Number>()->GetValue(), 42);
+        ASSERT(copy.TryAs<String>() == nullptr);
+        ASSERT(copy.TryAs<Bool>() == nullptr);
+
+        auto flag = ObjectHolder::Own(Bool(false));
+        ASSERT(flag);
+        ASSERT(!IsTrue(flag));
+        ASSERT(flag.TryAs<Bool>() != nullptr);
+        ASSERT(flag.TryAs<Number>() == nullptr);
+
+        auto none = ObjectHolder::None();
+        ASSERT(!none);
+        ASSERT(none.Get() != nullptr);
+        ASSERT(none.TryAs<NoneObject>() != nullptr);
+
+        number = std::move(flag);
+        ASSERT(!flag);
+        ASSERT(number.Get()->GetKind() == ObjectKind::BOOL);
+        ASSERT(number.TryAs<Bool>() != nullptr);
+
+        // A holder kept in the object it is assigned from
+        struct Box : Object {
+            ObjectHolder inner;
+
+            void Print(ostream &os) override {
+                os << "box";
+            }
+        };
+        Box box;
+        box.inner = ObjectHolder::Own(Number(7));
+        auto holder = ObjectHolder::Own(std::move(box));
+        holder = static_cast<Box *>(holder.Get())->inner;
+        ASSERT_EQUAL(holder.TryAs<Number>()->GetValue(), 7);
+    }
+
     void RunObjectHolderTests(TestRunner &tr) {
         RUN_TEST(tr, Runtime::TestNonowning);
         RUN_TEST(tr, Runtime::TestOwning);
         RUN_TEST(tr, Runtime::TestMove);
         RUN_TEST(tr, Runtime::TestNullptr);
+        RUN_TEST(tr, Runtime::TestInlineValues);
     }
 
 } /* namespace Runtime */
@@ -44,6 +44,7 @@ public:
 private:
     Parse::Lexer &lexer;
     Runtime::Closure declared_classes;
+    shared_ptr<const Runtime::Shape> empty_shape = Runtime::Shape::MakeEmpty();  // of the classes of the program
 
     // Suite -> NEWLINE INDENT (Statement)+ DEDENT
     unique_ptr<Ast::Statement> ParseSuite() {
@@ -121,7 +122,7 @@ private:
 
         auto[it, inserted] = declared_classes.insert({
                                                              class_name,
-                                                             ObjectHolder::Own(Runtime::Class(class_name, std::move(methods), base_class))
+                                                             ObjectHolder::Own(Runtime::Class(class_name, std::move(methods), base_class, empty_shape))
                                                      });
 
         if (!inserted) {
@@ -366,22 +367,22 @@ private:
 
         if (tok == '<') {
             lexer.NextToken();
-            return make_unique<Ast::Comparison>(Runtime::Less, std::move(result), ParseExpression());
+            return make_unique<Ast::Comparison>(Runtime::ComparisonKind::LESS, std::move(result), ParseExpression());
         } else if (tok == '>') {
             lexer.NextToken();
-            return make_unique<Ast::Comparison>(Runtime::Greater, std::move(result), ParseExpression());
+            return make_unique<Ast::Comparison>(Runtime::ComparisonKind::GREATER, std::move(result), ParseExpression());
         } else if (tok.Is<TokenType::Eq>()) {
             lexer.NextToken();
-            return make_unique<Ast::Comparison>(Runtime::Equal, std::move(result), ParseExpression());
+            return make_unique<Ast::Comparison>(Runtime::ComparisonKind::EQUAL, std::move(result), ParseExpression());
         } else if (tok.Is<TokenType::NotEq>()) {
             lexer.NextToken();
-            return make_unique<Ast::Comparison>(Runtime::NotEqual, std::move(result), ParseExpression());
+            return make_unique<Ast::Comparison>(Runtime::ComparisonKind::NOT_EQUAL, std::move(result), ParseExpression());
         } else if (tok.Is<TokenType::LessOrEq>()) {
             lexer.NextToken();
-            return make_unique<Ast::Comparison>(Runtime::LessOrEqual, std::move(result), ParseExpression());
+            return make_unique<Ast::Comparison>(Runtime::ComparisonKind::LESS_OR_EQUAL, std::move(result), ParseExpression());
         } else if (tok.Is<TokenType::GreaterOrEq>()) {
             lexer.NextToken();
-            return make_unique<Ast::Comparison>(Runtime::GreaterOrEqual, std::move(result), ParseExpression());
+            return make_unique<Ast::Comparison>(Runtime::ComparisonKind::GREATER_OR_EQUAL, std::move(result), ParseExpression());
         } else {
             return result;
         }
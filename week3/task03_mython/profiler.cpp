@@ -0,0 +1,159 @@
+#include "profiler.h"
+#include "object.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace Runtime {
+
+    namespace {
+        int64_t ToMicroseconds(Profiler::Clock::duration duration) {
+            return chrono::duration_cast<chrono::microseconds>(duration).count();
+        }
+
+        int64_t ToNanoseconds(Profiler::Clock::duration duration) {
+            return chrono::duration_cast<chrono::nanoseconds>(duration).count();
+        }
+    }
+
+    Profiler::Scope::Scope(Profiler &profiler) : outer_(current_) {
+        current_ = &profiler;
+        profiler.PushFrame(0, nullptr);
+    }
+
+    Profiler::Scope::~Scope() {
+        current_->total_ += current_->PopFrame();
+        current_ = outer_;
+    }
+
+    Profiler::Profiler() {
+        stack_nodes_.push_back({"main", 0, {}});
+    }
+
+    void Profiler::PushFrame(size_t node, MethodStats *stats) {
+        frames_.push_back({node, stats, Clock::now()});
+    }
+
+    Profiler::Clock::duration Profiler::PopFrame() {
+        const Frame &frame = frames_.back();
+        const Clock::duration elapsed = Clock::now() - frame.start;
+        const Clock::duration exclusive = elapsed - frame.children;
+        stack_nodes_[frame.node].exclusive += exclusive;
+        if (frame.stats != nullptr) {
+            frame.stats->exclusive += exclusive;
+            if (--frame.stats->running == 0) {
+                frame.stats->inclusive += elapsed;
+            }
+        }
+        frames_.pop_back();
+        if (!frames_.empty()) {
+            frames_.back().children += elapsed;
+        }
+        return elapsed;
+    }
+
+    void Profiler::EnterMethod(const ClassInstance &instance, const string &method) {
+        string name = instance.GetClass().GetName() + '.' + method;
+        const size_t parent = frames_.empty() ? 0 : frames_.back().node;
+        auto[it, inserted] = stack_nodes_[parent].children.insert({name, stack_nodes_.size()});
+        const size_t node = it->second;
+        if (inserted) {
+            stack_nodes_.push_back({name, parent, {}});
+        }
+
+        MethodStats &stats = method_stats_[move(name)];
+        stats.calls++;
+        stats.running++;
+        PushFrame(node, &stats);
+    }
+
+    void Profiler::ExitMethod() {
+        PopFrame();
+    }
+
+    void Profiler::OnNewInstance(ClassInstance &instance) {
+        instance.SetProfiled(*this);
+        allocations_[instance.GetClass().GetName()]++;
+        peak_live_instances_ = max(peak_live_instances_, ++live_instances_);
+    }
+
+    void Profiler::OnInstanceDestroyed() {
+        live_instances_--;
+    }
+
+    const map<string, Profiler::MethodStats> &Profiler::GetMethodStats() const {
+        return method_stats_;
+    }
+
+    const map<string, uint64_t> &Profiler::GetAllocations() const {
+        return allocations_;
+    }
+
+    size_t Profiler::GetPeakLiveInstances() const {
+        return peak_live_instances_;
+    }
+
+    uint64_t Profiler::GetExecutedStatements() const {
+        return executed_statements_;
+    }
+
+    uint64_t Profiler::GetExecutedInstructions() const {
+        return executed_instructions_;
+    }
+
+    void Profiler::WriteFoldedStacks(ostream &os) const {
+        for (size_t node = 0; node < stack_nodes_.size(); node++) {
+            const int64_t microseconds = ToMicroseconds(stack_nodes_[node].exclusive);
+            if (microseconds == 0) {
+                continue;
+            }
+            vector<const string *> names;
+            for (size_t i = node; ; i = stack_nodes_[i].parent) {
+                names.push_back(&stack_nodes_[i].name);
+                if (i == 0) {
+                    break;
+                }
+            }
+            for (auto it = names.rbegin(); it != names.rend(); it++) {
+                os << (it == names.rbegin() ? "" : ";") << **it;
+            }
+            os << ' ' << microseconds << '\n';
+        }
+    }
+
+    // The names are of Mython identifiers, nothing in them is to be escaped
+    void Profiler::WriteJson(ostream &os) const {
+        vector<const pair<const string, MethodStats> *> methods;
+        for (const auto &method : method_stats_) {
+            methods.push_back(&method);
+        }
+        stable_sort(methods.begin(), methods.end(), [](auto lhs, auto rhs) {
+            return lhs->second.exclusive > rhs->second.exclusive;
+        });
+
+        os << "{\n";
+        os << "  \"total_ns\": " << ToNanoseconds(total_) << ",\n";
+        os << "  \"executed_statements\": " << executed_statements_ << ",\n";
+        os << "  \"executed_instructions\": " << executed_instructions_ << ",\n";
+        os << "  \"peak_live_instances\": " << peak_live_instances_ << ",\n";
+        os << "  \"methods\": [";
+        for (size_t i = 0; i < methods.size(); i++) {
+            const auto &[name, stats] = *methods[i];
+            os << (i == 0 ? "\n" : ",\n")
+               << "    {\"name\": \"" << name << "\", \"calls\": " << stats.calls
+               << ", \"inclusive_ns\": " << ToNanoseconds(stats.inclusive)
+               << ", \"exclusive_ns\": " << ToNanoseconds(stats.exclusive) << "}";
+        }
+        os << (methods.empty() ? "],\n" : "\n  ],\n");
+        os << "  \"allocations\": {";
+        bool first = true;
+        for (const auto &[class_name, count] : allocations_) {
+            os << (first ? "\n" : ",\n") << "    \"" << class_name << "\": " << count;
+            first = false;
+        }
+        os << (allocations_.empty() ? "}\n" : "\n  }\n");
+        os << "}\n";
+    }
+
+} /* namespace Runtime */
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class TestRunner;
+
+namespace Runtime {
+
+    class ClassInstance;
+
+    // Collects where a program spends its time: the calls of the methods by the stacks they are made from,
+    // the instances created by classes and the statements executed. Profiling is on for a thread while
+    // a Scope of a profiler exists there; the hooks cost a check of Current() otherwise
+    class Profiler {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        struct MethodStats {
+            uint64_t calls = 0;
+            Clock::duration inclusive{0};  // of the outermost calls, a recursive call is in its caller already
+            Clock::duration exclusive{0};  // without the methods called from the method
+            size_t running = 0;            // the calls not finished yet
+        };
+
+        // Makes the profiler current in the thread for its lifetime, the time of the scope is the total time
+        class Scope {
+        public:
+            explicit Scope(Profiler &profiler);
+
+            ~Scope();
+
+            Scope(const Scope &) = delete;
+
+            Scope &operator=(const Scope &) = delete;
+
+        private:
+            Profiler *outer_;
+        };
+
+        // Times the call of the method of the instance for its lifetime, if there is a profiler
+        class MethodCall {
+        public:
+            MethodCall(Profiler *profiler, const ClassInstance &instance, const std::string &method) : profiler_(profiler) {
+                if (profiler_ != nullptr) {
+                    profiler_->EnterMethod(instance, method);
+                }
+            }
+
+            ~MethodCall() {
+                if (profiler_ != nullptr) {
+                    profiler_->ExitMethod();
+                }
+            }
+
+            MethodCall(const MethodCall &) = delete;
+
+            MethodCall &operator=(const MethodCall &) = delete;
+
+        private:
+            Profiler *profiler_;
+        };
+
+        // The profiler of the thread, nullptr if profiling is off
+        static Profiler *Current() {
+            return current_;
+        }
+
+        Profiler();
+
+        void EnterMethod(const ClassInstance &instance, const std::string &method);
+
+        void ExitMethod();
+
+        // The instance is counted as live until it is destroyed, so the profiler must outlive it
+        void OnNewInstance(ClassInstance &instance);
+
+        // Of an instance counted by this profiler
+        void OnInstanceDestroyed();
+
+        void OnStatement() {
+            executed_statements_++;
+        }
+
+        void OnInstruction() {
+            executed_instructions_++;
+        }
+
+        // By "Class.method" of the class of the instance
+        const std::map<std::string, MethodStats> &GetMethodStats() const;
+
+        // By class names
+        const std::map<std::string, uint64_t> &GetAllocations() const;
+
+        size_t GetPeakLiveInstances() const;
+
+        uint64_t GetExecutedStatements() const;
+
+        uint64_t GetExecutedInstructions() const;
+
+        // A line per stack, as "main;Class.method;Class.method <exclusive microseconds>", for flamegraph.pl
+        void WriteFoldedStacks(std::ostream &os) const;
+
+        void WriteJson(std::ostream &os) const;
+
+    private:
+        // Of the tree of the call stacks, 0 is the top-level code
+        struct StackNode {
+            std::string name;
+            size_t parent;
+            std::unordered_map<std::string, size_t> children;
+            Clock::duration exclusive{0};
+        };
+
+        struct Frame {
+            size_t node;
+            MethodStats *stats;  // nullptr for the top-level code
+            Clock::time_point start;
+            Clock::duration children{0};
+        };
+
+        void PushFrame(size_t node, MethodStats *stats);
+
+        Clock::duration PopFrame();
+
+        inline static thread_local Profiler *current_ = nullptr;
+
+        std::vector<StackNode> stack_nodes_;
+        std::vector<Frame> frames_;
+        std::map<std::string, MethodStats> method_stats_;
+        std::map<std::string, uint64_t> allocations_;
+        size_t live_instances_ = 0;
+        size_t peak_live_instances_ = 0;
+        uint64_t executed_statements_ = 0;
+        uint64_t executed_instructions_ = 0;
+        Clock::duration total_{0};
+    };
+
+    void RunProfilerTests(TestRunner &tr);
+
+} /* namespace Runtime */
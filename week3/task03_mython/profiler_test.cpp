@@ -0,0 +1,129 @@
+#include "profiler.h"
+#include "bytecode.h"
+#include "vm.h"
+#include "lexer.h"
+#include "parse.h"
+#include "statement.h"
+
+#include <test_runner.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace Runtime {
+
+    namespace {
+        const string FIB_PROGRAM = R"(
+class Counter:
+  def __init__():
+    self.value = 0
+
+class Fib:
+  def calc(n):
+    c = Counter()
+    if n < 2:
+      return n
+    return self.calc(n - 1) + self.calc(n - 2)
+
+  def __str__():
+    return 'fib'
+
+f = Fib()
+print f.calc(6), f
+)";
+
+        // Both engines under the profiler
+        void ProfileProgram(const string &program, bool on_vm, Profiler &profiler) {
+            istringstream is(program);
+            Parse::Lexer lexer(is);
+            auto tree = ParseProgram(lexer);
+
+            ostringstream os;
+            Profiler::Scope profiling(profiler);
+            Closure closure;
+            if (on_vm) {
+                const Bytecode::Program bytecode = Bytecode::Compile(*tree);
+                Bytecode::VirtualMachine(bytecode, os).Run(closure);
+            } else {
+                Ast::Print::SetOutputStream(os);
+                tree->Execute(closure);
+            }
+            ASSERT_EQUAL(os.str(), "8 fib\n");
+        }
+    }
+
+    void TestProfilerCountsCallsAndInstances() {
+        for (bool on_vm : {false, true}) {
+            Profiler profiler;
+            ProfileProgram(FIB_PROGRAM, on_vm, profiler);
+
+            const auto &methods = profiler.GetMethodStats();
+            ASSERT_EQUAL(methods.size(), 3u);
+            const auto &calc = methods.at("Fib.calc");
+            ASSERT_EQUAL(calc.calls, 25u);
+            ASSERT_EQUAL(methods.at("Counter.__init__").calls, 25u);
+            ASSERT_EQUAL(methods.at("Fib.__str__").calls, 1u);
+            ASSERT(calc.exclusive <= calc.inclusive);
+
+            ASSERT_EQUAL(profiler.GetAllocations(), (map<string, uint64_t>{{"Counter", 25}, {"Fib", 1}}));
+            // A counter of every frame of the deepest recursion and f
+            ASSERT_EQUAL(profiler.GetPeakLiveInstances(), 7u);
+            ASSERT(on_vm ? profiler.GetExecutedInstructions() > 0 : profiler.GetExecutedStatements() > 0);
+        }
+    }
+
+    void TestProfilerOutputs() {
+        Profiler profiler;
+        ProfileProgram(FIB_PROGRAM, true, profiler);
+
+        ostringstream folded;
+        profiler.WriteFoldedStacks(folded);
+        istringstream lines(folded.str());
+        for (string line; getline(lines, line);) {
+            ASSERT_EQUAL(line.rfind("main", 0), 0u);
+            ASSERT(line.find(' ') != string::npos);
+        }
+
+        ostringstream json;
+        profiler.WriteJson(json);
+        ASSERT(json.str().find(R"("name": "Fib.calc", "calls": 25)") != string::npos);
+        ASSERT(json.str().find(R"("Counter": 25)") != string::npos);
+        ASSERT(json.str().find(R"("peak_live_instances": 7)") != string::npos);
+    }
+
+    void TestProfilerIsOffOutsideScope() {
+        ASSERT(Profiler::Current() == nullptr);
+        {
+            Profiler profiler;
+            Profiler::Scope profiling(profiler);
+            ASSERT(Profiler::Current() == &profiler);
+        }
+        ASSERT(Profiler::Current() == nullptr);
+    }
+
+    void TestInstanceIsUncountedByItsProfiler() {
+        Class cls("Point", {}, nullptr);
+        Profiler counting, other;
+        {
+            auto instance = make_unique<ClassInstance>(cls);
+            counting.OnNewInstance(*instance);
+            Profiler::Scope profiling(other);
+            instance.reset();
+        }
+        ClassInstance next(cls);
+        counting.OnNewInstance(next);
+        ASSERT_EQUAL(counting.GetPeakLiveInstances(), 1u);
+        ASSERT_EQUAL(other.GetPeakLiveInstances(), 0u);
+    }
+
+    void RunProfilerTests(TestRunner &tr) {
+        RUN_TEST(tr, Runtime::TestProfilerCountsCallsAndInstances);
+        RUN_TEST(tr, Runtime::TestProfilerOutputs);
+        RUN_TEST(tr, Runtime::TestProfilerIsOffOutsideScope);
+        RUN_TEST(tr, Runtime::TestInstanceIsUncountedByItsProfiler);
+    }
+
+} /* namespace Runtime */
@@ -0,0 +1,61 @@
+#include "shape.h"
+
+#include <utility>
+
+using namespace std;
+
+namespace Runtime {
+
+    shared_ptr<const Shape> Shape::MakeEmpty() {
+        return shared_ptr<const Shape>(new Shape());
+    }
+
+    Shape::Shape(const Shape &parent, string name)
+            : name_(move(name)), field_count_(parent.field_count_ + 1),
+              field_names_(parent.field_names_), offsets_by_name_(parent.offsets_by_name_) {
+        field_names_.push_back(&name_);
+        offsets_by_name_.emplace(name_, field_count_ - 1);
+    }
+
+    Shape::~Shape() {
+        for (const Shape *child = first_child_.load(memory_order_acquire); child != nullptr;) {
+            delete exchange(child, child->next_sibling_);
+        }
+    }
+
+    optional<size_t> Shape::FindField(const string &name) const {
+        if (auto it = offsets_by_name_.find(name); it != offsets_by_name_.end()) {
+            return it->second;
+        }
+        return nullopt;
+    }
+
+    const Shape &Shape::AddField(const string &name) const {
+        const Shape *first_child = first_child_.load(memory_order_acquire);
+        unique_ptr<Shape> added;
+        while (true) {
+            for (const Shape *child = first_child; child != nullptr; child = child->next_sibling_) {
+                if (child->name_ == name) {
+                    return *child;
+                }
+            }
+            // Published only if no shape is added meanwhile, else the added ones are looked through again
+            if (!added) {
+                added.reset(new Shape(*this, name));
+            }
+            added->next_sibling_ = first_child;
+            if (first_child_.compare_exchange_weak(first_child, added.get(), memory_order_acq_rel, memory_order_acquire)) {
+                return *added.release();
+            }
+        }
+    }
+
+    size_t Shape::GetFieldCount() const {
+        return field_count_;
+    }
+
+    const string &Shape::GetFieldName(size_t offset) const {
+        return *field_names_[offset];
+    }
+
+} /* namespace Runtime */
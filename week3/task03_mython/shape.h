@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class TestRunner;
+
+namespace Runtime {
+
+    // Layout of the fields of class instances (a hidden class): the instances that got the same fields
+    // in the same order share a shape, and the value of a field is at the same offset in all of them.
+    // The shapes of a program are a tree from the empty shape its classes share, freed with it. The tree only grows,
+    // a shape is added once and never changed, so it is read and grown by the threads running the program without locks.
+    // A shape has the offsets of all its fields, so a field is found in constant time at the cost of copying them once
+    class Shape {
+    public:
+        // The root of a new tree of shapes, of the instances without fields
+        static std::shared_ptr<const Shape> MakeEmpty();
+
+        ~Shape();
+
+        Shape(const Shape &) = delete;
+
+        Shape &operator=(const Shape &) = delete;
+
+        // nullopt if the instances of the shape have no such field
+        std::optional<size_t> FindField(const std::string &name) const;
+
+        // The shape of the instances of this shape after the field is added to them, at offset GetFieldCount()
+        const Shape &AddField(const std::string &name) const;
+
+        size_t GetFieldCount() const;
+
+        const std::string &GetFieldName(size_t offset) const;
+
+    private:
+        Shape() = default;
+
+        Shape(const Shape &parent, std::string name);
+
+        std::string name_;  // of the last field, the others are of the ancestors
+        size_t field_count_ = 0;
+
+        // Point to the names of the shape and its ancestors, which outlive it
+        std::vector<const std::string *> field_names_;  // by offset
+        std::unordered_map<std::string_view, size_t> offsets_by_name_;
+
+        // The shapes of the fields added to this one, a list by next_sibling_ that only grows at its head
+        mutable std::atomic<const Shape *> first_child_ = nullptr;
+        const Shape *next_sibling_ = nullptr;
+    };
+
+    void RunShapeTests(TestRunner &tr);
+
+} /* namespace Runtime */
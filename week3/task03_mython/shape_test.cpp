@@ -0,0 +1,133 @@
+#include "shape.h"
+#include "object.h"
+#include "statement.h"
+
+#include <test_runner.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace Runtime {
+
+    void TestShapesAreShared() {
+        const auto empty = Shape::MakeEmpty();
+        const Shape &xy = empty->AddField("x").AddField("y");
+        ASSERT(&xy == &empty->AddField("x").AddField("y"));
+        ASSERT(&xy != &empty->AddField("y").AddField("x"));
+
+        ASSERT_EQUAL(xy.GetFieldCount(), 2u);
+        ASSERT_EQUAL(*xy.FindField("x"), 0u);
+        ASSERT_EQUAL(*xy.FindField("y"), 1u);
+        ASSERT(!xy.FindField("z"));
+        ASSERT_EQUAL(xy.GetFieldName(0), "x");
+        ASSERT_EQUAL(xy.GetFieldName(1), "y");
+        ASSERT(&xy != &Shape::MakeEmpty()->AddField("x").AddField("y"));
+    }
+
+    void TestShapesHaveOwnOffsets() {
+        const auto empty = Shape::MakeEmpty();
+        const Shape &x = empty->AddField("x");
+        const Shape &xy = x.AddField("y");
+        const Shape &xz = x.AddField("z");
+
+        ASSERT(!x.FindField("y"));
+        ASSERT(!xy.FindField("z"));
+        ASSERT(!xz.FindField("y"));
+        ASSERT_EQUAL(*xy.FindField("y"), 1u);
+        ASSERT_EQUAL(*xz.FindField("z"), 1u);
+        ASSERT_EQUAL(xz.GetFieldName(0), "x");
+        ASSERT_EQUAL(xz.GetFieldName(1), "z");
+        ASSERT(!empty->FindField("x"));
+    }
+
+    void TestShapesAreAddedOnThreadsAtOnce() {
+        const auto empty = Shape::MakeEmpty();
+        const vector<string> names{"a", "b", "c", "d", "e", "f", "g", "h"};
+        vector<vector<const Shape *>> shapes_by_threads(8);
+        vector<thread> threads;
+        for (auto &shapes : shapes_by_threads) {
+            threads.emplace_back([&empty, &names, &shapes] {
+                for (const auto &first_name : names) {
+                    for (const auto &second_name : names) {
+                        shapes.push_back(&empty->AddField(first_name).AddField(second_name));
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        for (const auto &shapes : shapes_by_threads) {
+            ASSERT(shapes == shapes_by_threads.front());
+        }
+    }
+
+    void TestClassesShareEmptyShape() {
+        const auto empty = Shape::MakeEmpty();
+        Class base("Base", {}, nullptr, empty);
+        Class derived("Derived", {}, &base);
+        Class other("Other", {}, nullptr, empty);
+        ASSERT(&base.GetEmptyShape() == empty.get());
+        ASSERT(&derived.GetEmptyShape() == empty.get());
+        ASSERT(&other.GetEmptyShape() == empty.get());
+        ASSERT(&Class("Alone", {}, nullptr).GetEmptyShape() != empty.get());
+    }
+
+    void TestInstancesOfOneClassShareShape() {
+        Class cls("Point", {}, nullptr);
+        ClassInstance a(cls);
+        ClassInstance b(cls);
+        ASSERT(&a.GetShape() == &cls.GetEmptyShape());
+
+        a.Fields()["x"] = ObjectHolder::Own(Number(1));
+        a.Fields()["y"] = ObjectHolder::Own(Number(2));
+        b.Fields()["x"] = ObjectHolder::Own(Number(3));
+        b.Fields()["y"] = ObjectHolder::Own(Number(4));
+        ASSERT(&a.GetShape() == &b.GetShape());
+
+        // Assigning an existing field keeps the shape
+        a.Fields()["x"] = ObjectHolder::Own(Number(5));
+        ASSERT(&a.GetShape() == &b.GetShape());
+        ASSERT_EQUAL(a.GetField(*a.GetShape().FindField("x")).TryAs<Number>()->GetValue(), 5);
+        ASSERT_EQUAL(b.GetField(*b.GetShape().FindField("y")).TryAs<Number>()->GetValue(), 4);
+    }
+
+    void TestFieldsView() {
+        Class cls("Point", {}, nullptr);
+        ClassInstance instance(cls);
+        const auto &const_instance = instance;
+
+        ASSERT(instance.Fields().empty());
+        ASSERT(const_instance.Fields().find("x") == const_instance.Fields().end());
+        ASSERT_THROWS(const_instance.Fields().at("x"), out_of_range);
+
+        instance.Fields()["x"] = ObjectHolder::Own(Number(1));
+        instance.Fields()["y"] = ObjectHolder::Own(Number(2));
+        ASSERT_EQUAL(instance.Fields().size(), 2u);
+
+        vector<string> names;
+        for (const auto &[name, value] : const_instance.Fields()) {
+            names.push_back(name);
+        }
+        ASSERT_EQUAL(names, (vector<string>{"x", "y"}));
+
+        auto it = instance.Fields().find("y");
+        ASSERT(it != instance.Fields().end());
+        ASSERT_EQUAL(it->first, "y");
+        ASSERT_EQUAL(it->second.TryAs<Number>()->GetValue(), 2);
+        ASSERT_EQUAL(const_instance.Fields().at("x").TryAs<Number>()->GetValue(), 1);
+    }
+
+    void RunShapeTests(TestRunner &tr) {
+        RUN_TEST(tr, Runtime::TestShapesAreShared);
+        RUN_TEST(tr, Runtime::TestShapesHaveOwnOffsets);
+        RUN_TEST(tr, Runtime::TestShapesAreAddedOnThreadsAtOnce);
+        RUN_TEST(tr, Runtime::TestClassesShareEmptyShape);
+        RUN_TEST(tr, Runtime::TestInstancesOfOneClassShareShape);
+        RUN_TEST(tr, Runtime::TestFieldsView);
+    }
+
+} /* namespace Runtime */
@@ -1,5 +1,6 @@
 #include "statement.h"
 #include "object.h"
+#include "profiler.h"
 
 #include <iostream>
 #include <sstream>
@@ -19,6 +20,14 @@ namespace Ast {
         return obj_args;
     }
 
+    // The errors of the method itself are passed as they are
+    ObjectHolder CallOperator(Runtime::ClassInstance &lhs, const string &method, const ObjectHolder &rhs, const char *error) {
+        if (!lhs.HasMethod(method, 1)) {
+            throw runtime_error(error);
+        }
+        return lhs.Call(method, {rhs});
+    }
+
     ObjectHolder Assignment::Execute(Closure &closure) {
         closure[var_name] = right_value->Execute(closure);
         return closure[var_name];
@@ -31,19 +40,20 @@ namespace Ast {
     VariableValue::VariableValue(std::vector<std::string> dotted_ids) : dotted_ids(move(dotted_ids)) {}
 
     ObjectHolder VariableValue::Execute(Closure &closure) {
-        Closure *cur_cl = &closure;
-        for (int i = 0; i < dotted_ids.size() - 1; i++) {
-            auto it_cur_cl = cur_cl->find(dotted_ids.at(i));
-            if (it_cur_cl == cur_cl->end()) {
+        auto it = closure.find(dotted_ids.front());
+        if (it == closure.end()) {
+            throw runtime_error("not found variable");
+        }
+        const ObjectHolder *value = &it->second;
+        for (size_t i = 1; i < dotted_ids.size(); i++) {
+            auto fields = value->TryAs<Runtime::ClassInstance>()->Fields();
+            auto it_field = fields.find(dotted_ids[i]);
+            if (it_field == fields.end()) {
                 throw runtime_error("not found variable");
             }
-            cur_cl = &it_cur_cl->second.TryAs<Runtime::ClassInstance>()->Fields();
-        }
-        auto it_cur_cl = cur_cl->find(dotted_ids.at(dotted_ids.size() - 1));
-        if (it_cur_cl == cur_cl->end()) {
-            throw runtime_error("not found variable");
+            value = &(*it_field).second;
         }
-        return it_cur_cl->second;
+        return *value;
     }
 
     unique_ptr<Print> Print::Variable(std::string var) {
@@ -69,7 +79,7 @@ namespace Ast {
         return ObjectHolder();
     }
 
-    ostream *Print::output = &cout;
+    thread_local ostream *Print::output = &cout;
 
     void Print::SetOutputStream(ostream &output_stream) {
         output = &output_stream;
@@ -103,12 +113,7 @@ namespace Ast {
             return ObjectHolder::Own(Runtime::Number(lhs_num_ptr->GetValue() + rhs_num_ptr->GetValue()));
         }
         if (auto lhs_inst_ptr = lhs_op.TryAs<Runtime::ClassInstance>(); lhs_inst_ptr != nullptr) {
-            try {
-                return lhs_inst_ptr->Call("__add__", {rhs_op});
-            }
-            catch (const runtime_error &e) {
-                throw runtime_error("statement.cpp Add::Execute [inst wo __add__()]");
-            }
+            return CallOperator(*lhs_inst_ptr, "__add__", rhs_op, "statement.cpp Add::Execute [inst wo __add__()]");
         }
         throw runtime_error("statement.cpp Add::Execute");
     }
@@ -120,12 +125,7 @@ namespace Ast {
             return ObjectHolder::Own(Runtime::Number(lhs_num_ptr->GetValue() - rhs_num_ptr->GetValue()));
         }
         if (auto lhs_inst_ptr = lhs_op.TryAs<Runtime::ClassInstance>(); lhs_inst_ptr != nullptr) {
-            try {
-                return lhs_inst_ptr->Call("__sub__", {rhs_op});
-            }
-            catch (const runtime_error &e) {
-                throw runtime_error("statement.cpp Sub::Execute [inst wo __sub__()]");
-            }
+            return CallOperator(*lhs_inst_ptr, "__sub__", rhs_op, "statement.cpp Sub::Execute [inst wo __sub__()]");
         }
         throw runtime_error("statement.cpp Sub::Execute");
     }
@@ -137,12 +137,7 @@ namespace Ast {
             return ObjectHolder::Own(Runtime::Number(lhs_num_ptr->GetValue() * rhs_num_ptr->GetValue()));
         }
         if (auto lhs_inst_ptr = lhs_op.TryAs<Runtime::ClassInstance>(); lhs_inst_ptr != nullptr) {
-            try {
-                return lhs_inst_ptr->Call("__mul__", {rhs_op});
-            }
-            catch (const runtime_error &e) {
-                throw runtime_error("statement.cpp Mul::Execute [inst wo __mul__()]");
-            }
+            return CallOperator(*lhs_inst_ptr, "__mul__", rhs_op, "statement.cpp Mul::Execute [inst wo __mul__()]");
         }
         throw runtime_error("statement.cpp Mult::Execute");
     }
@@ -154,27 +149,25 @@ namespace Ast {
             return ObjectHolder::Own(Runtime::Number(lhs_num_ptr->GetValue() / rhs_num_ptr->GetValue()));
         }
         if (auto lhs_inst_ptr = lhs_op.TryAs<Runtime::ClassInstance>(); lhs_inst_ptr != nullptr) {
-            try {
-                return lhs_inst_ptr->Call("__div__", {rhs_op});
-            }
-            catch (const runtime_error &e) {
-                throw runtime_error("statement.cpp Div::Execute [inst wo __div__()]");
-            }
+            return CallOperator(*lhs_inst_ptr, "__div__", rhs_op, "statement.cpp Div::Execute [inst wo __div__()]");
         }
         throw runtime_error("statement.cpp Div::Execute");
     }
 
     ObjectHolder Compound::Execute(Closure &closure) {
-        ObjectHolder res;
+        Completion completion = Completion::NORMAL;
+        return ExecuteInBlock(closure, completion);
+    }
+
+    ObjectHolder Compound::ExecuteInBlock(Closure &closure, Completion &completion) {
+        Runtime::Profiler *profiler = Runtime::Profiler::Current();
         for (const auto &st : this->statements) {
-            res = st->Execute(closure);
-            if (dynamic_cast<Return *>(st.get()) != nullptr) {  // if return is before end of compound
-                return res;
+            if (profiler != nullptr) {
+                profiler->OnStatement();
             }
-            if (dynamic_cast<IfElse *>(st.get()) != nullptr) {
-                if (res) {
-                    return res;
-                }
+            ObjectHolder res = st->ExecuteInBlock(closure, completion);
+            if (completion == Completion::RETURN) {  // if return is before end of compound
+                return res;
             }
         }
         return ObjectHolder::None();
@@ -184,6 +177,12 @@ namespace Ast {
         return statement->Execute(closure);
     }
 
+    ObjectHolder Return::ExecuteInBlock(Closure &closure, Completion &completion) {
+        ObjectHolder res = statement->Execute(closure);
+        completion = Completion::RETURN;
+        return res;
+    }
+
     ClassDefinition::ClassDefinition(ObjectHolder class_) : cls(move(class_)), class_name(cls.TryAs<Runtime::Class>()->GetName()) {}
 
     ObjectHolder ClassDefinition::Execute(Runtime::Closure &closure) {
@@ -198,12 +197,12 @@ namespace Ast {
     }
 
     ObjectHolder FieldAssignment::Execute(Runtime::Closure &closure) {
-        Closure *closure_to_assign = &closure;
-        for (int i = 0; i < object.dotted_ids.size(); i++) {
-            closure_to_assign = &closure_to_assign->at(object.dotted_ids.at(i)).TryAs<Runtime::ClassInstance>()->Fields();
+        ObjectHolder object_to_assign = closure.at(object.dotted_ids.front());
+        for (size_t i = 1; i < object.dotted_ids.size(); i++) {
+            object_to_assign = object_to_assign.TryAs<Runtime::ClassInstance>()->Fields().at(object.dotted_ids[i]);
         }
-        closure_to_assign->insert_or_assign(this->field_name, right_value->Execute(closure));
-        return closure_to_assign->at(this->field_name);
+        ObjectHolder value = right_value->Execute(closure);
+        return object_to_assign.TryAs<Runtime::ClassInstance>()->Fields()[field_name] = move(value);
     }
 
     IfElse::IfElse(
@@ -213,11 +212,16 @@ namespace Ast {
     ) : condition(move(condition)), if_body(move(if_body)), else_body(move(else_body)) {}
 
     ObjectHolder IfElse::Execute(Runtime::Closure &closure) {
+        Completion completion = Completion::NORMAL;
+        return ExecuteInBlock(closure, completion);
+    }
+
+    ObjectHolder IfElse::ExecuteInBlock(Runtime::Closure &closure, Completion &completion) {
         if (Runtime::IsTrue(condition->Execute(closure))) {
-            return if_body->Execute(closure);
+            return if_body->ExecuteInBlock(closure, completion);
         } else {
             if (else_body) {
-                return else_body->Execute(closure);
+                return else_body->ExecuteInBlock(closure, completion);
             } else {
                 return ObjectHolder::None();
             }
@@ -243,6 +247,10 @@ namespace Ast {
             Comparator cmp, unique_ptr<Statement> lhs, unique_ptr<Statement> rhs
     ) : comparator(move(cmp)), left(move(lhs)), right(move(rhs)) {}
 
+    Comparison::Comparison(
+            Runtime::ComparisonKind kind, unique_ptr<Statement> lhs, unique_ptr<Statement> rhs
+    ) : comparator(Runtime::GetComparator(kind)), kind(kind), left(move(lhs)), right(move(rhs)) {}
+
     ObjectHolder Comparison::Execute(Runtime::Closure &closure) {
         auto lhs_op = left->Execute(closure), rhs_op = right->Execute(closure);
         return ObjectHolder::Own(Runtime::Bool(comparator(lhs_op, rhs_op)));
@@ -260,6 +268,9 @@ namespace Ast {
 
     ObjectHolder NewInstance::Execute(Runtime::Closure &closure) {
         ObjectHolder res = ObjectHolder::Own(Runtime::ClassInstance(class_));
+        if (auto profiler = Runtime::Profiler::Current(); profiler != nullptr) {
+            profiler->OnNewInstance(*res.TryAs<Runtime::ClassInstance>());
+        }
 
         if (res.TryAs<Runtime::ClassInstance>()->HasMethod("__init__", this->args.size())) {
             res.TryAs<Runtime::ClassInstance>()->Call("__init__", TransformFromStToObj(this->args, closure));
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "comparators.h"
 #include "object_holder.h"
 #include "object.h"
 
@@ -7,16 +8,35 @@
 #include <string>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <vector>
 
 class TestRunner;
 
+namespace Bytecode {
+    class Compiler;
+}
+
 namespace Ast {
 
+    // How a statement of a block completes: a return completes the method it is in
+    enum class Completion {
+        NORMAL,
+        RETURN,
+    };
+
     struct Statement {
         virtual ~Statement() = default;
 
         virtual ObjectHolder Execute(Runtime::Closure &closure) = 0;
+
+        // As Execute, sets the completion to RETURN when the execution ends with a return
+        virtual ObjectHolder ExecuteInBlock(Runtime::Closure &closure, Completion &) {
+            return Execute(closure);
+        }
+
+        // Emits the code that leaves exactly one value on the stack: the result of Execute
+        virtual void Compile(Bytecode::Compiler &compiler) = 0;
     };
 
     template<typename T>
@@ -27,8 +47,19 @@ namespace Ast {
         }
 
         ObjectHolder Execute(Runtime::Closure &) override {
-            return ObjectHolder::Share(value);
+            return HoldValue();
+        }
+
+        // A copy of a number or a bool is cheaper than a holder sharing it
+        ObjectHolder HoldValue() {
+            if constexpr (ObjectHolder::IS_STORED_INLINE<T>) {
+                return ObjectHolder::Own(T(value));
+            } else {
+                return ObjectHolder::Share(value);
+            }
         }
+
+        void Compile(Bytecode::Compiler &compiler) override;
     };
 
     using NumericConst = ValueStatement<Runtime::Number>;
@@ -43,6 +74,8 @@ namespace Ast {
         explicit VariableValue(std::vector<std::string> dotted_ids);
 
         ObjectHolder Execute(Runtime::Closure &closure) override;
+
+        void Compile(Bytecode::Compiler &compiler) override;
     };
 
     struct Assignment : Statement {
@@ -52,6 +85,8 @@ namespace Ast {
         Assignment(std::string var, std::unique_ptr<Statement> rv);
 
         ObjectHolder Execute(Runtime::Closure &closure) override;
+
+        void Compile(Bytecode::Compiler &compiler) override;
     };
 
     struct FieldAssignment : Statement {
@@ -62,12 +97,16 @@ namespace Ast {
         FieldAssignment(VariableValue object, std::string field_name, std::unique_ptr<Statement> rv);
 
         ObjectHolder Execute(Runtime::Closure &closure) override;
+
+        void Compile(Bytecode::Compiler &compiler) override;
     };
 
     struct None : Statement {
         ObjectHolder Execute(Runtime::Closure &) override {
             return ObjectHolder::None();
         }
+
+        void Compile(Bytecode::Compiler &compiler) override;
     };
 
     class Print : public Statement {
@@ -80,11 +119,34 @@ namespace Ast {
 
         ObjectHolder Execute(Runtime::Closure &closure) override;
 
+        void Compile(Bytecode::Compiler &compiler) override;
+
+        // Per thread, not process-wide: only the calling thread prints to the stream from now on, the other threads
+        // keep their streams (std::cout by default). OutputScope also restores the previous stream
         static void SetOutputStream(std::ostream &output_stream);
 
+        // Sets the output stream of the thread for its lifetime
+        class OutputScope {
+        public:
+            explicit OutputScope(std::ostream &output_stream) : outer_(output) {
+                output = &output_stream;
+            }
+
+            ~OutputScope() {
+                output = outer_;
+            }
+
+            OutputScope(const OutputScope &) = delete;
+
+            OutputScope &operator=(const OutputScope &) = delete;
+
+        private:
+            std::ostream *outer_;
+        };
+
     private:
         std::vector<std::unique_ptr<Statement>> args;
-        static std::ostream *output;
+        static thread_local std::ostream *output;
     };
 
     struct MethodCall : Statement {
@@ -99,6 +161,8 @@ namespace Ast {
         );
 
         ObjectHolder Execute(Runtime::Closure &closure) override;
+
+        void Compile(Bytecode::Compiler &compiler) override;
     };
 
     struct NewInstance : Statement {
@@ -110,6 +174,8 @@ namespace Ast {
         NewInstance(const Runtime::Class &class_, std::vector<std::unique_ptr<Statement>> args);
 
         ObjectHolder Execute(Runtime::Closure &closure) override;
+
+        void Compile(Bytecode::Compiler &compiler) override;
     };
 
     class UnaryOperation : public Statement {
@@ -126,6 +192,8 @@ namespace Ast {
         using UnaryOperation::UnaryOperation;
 
         ObjectHolder Execute(Runtime::Closure &closure) override;
+
+        void Compile(Bytecode::Compiler &compiler) override;
     };
 
     class BinaryOperation : public Statement {
@@ -143,6 +211,8 @@ namespace Ast {
         using BinaryOperation::BinaryOperation;
 
         ObjectHolder Execute(Runtime::Closure &closure) override;
+
+        void Compile(Bytecode::Compiler &compiler) override;
     };
 
     class Sub : public BinaryOperation {
@@ -150,6 +220,8 @@ namespace Ast {
         using BinaryOperation::BinaryOperation;
 
         ObjectHolder Execute(Runtime::Closure &closure) override;
+
+        void Compile(Bytecode::Compiler &compiler) override;
     };
 
     class Mult : public BinaryOperation {
@@ -157,6 +229,8 @@ namespace Ast {
         using BinaryOperation::BinaryOperation;
 
         ObjectHolder Execute(Runtime::Closure &closure) override;
+
+        void Compile(Bytecode::Compiler &compiler) override;
     };
 
     class Div : public BinaryOperation {
@@ -164,6 +238,8 @@ namespace Ast {
         using BinaryOperation::BinaryOperation;
 
         ObjectHolder Execute(Runtime::Closure &closure) override;
+
+        void Compile(Bytecode::Compiler &compiler) override;
     };
 
     class Or : public BinaryOperation {
@@ -171,6 +247,8 @@ namespace Ast {
         using BinaryOperation::BinaryOperation;
 
         ObjectHolder Execute(Runtime::Closure &closure) override;
+
+        void Compile(Bytecode::Compiler &compiler) override;
     };
 
     class And : public BinaryOperation {
@@ -178,6 +256,8 @@ namespace Ast {
         using BinaryOperation::BinaryOperation;
 
         ObjectHolder Execute(Runtime::Closure &closure) override;
+
+        void Compile(Bytecode::Compiler &compiler) override;
     };
 
     class Not : public UnaryOperation {
@@ -185,6 +265,8 @@ namespace Ast {
         using UnaryOperation::UnaryOperation;
 
         ObjectHolder Execute(Runtime::Closure &closure) override;
+
+        void Compile(Bytecode::Compiler &compiler) override;
     };
 
     class Compound : public Statement {
@@ -200,6 +282,10 @@ namespace Ast {
 
         ObjectHolder Execute(Runtime::Closure &closure) override;
 
+        ObjectHolder ExecuteInBlock(Runtime::Closure &closure, Completion &completion) override;
+
+        void Compile(Bytecode::Compiler &compiler) override;
+
     private:
         std::vector<std::unique_ptr<Statement>> statements;
     };
@@ -212,6 +298,10 @@ namespace Ast {
 
         ObjectHolder Execute(Runtime::Closure &closure) override;
 
+        ObjectHolder ExecuteInBlock(Runtime::Closure &closure, Completion &completion) override;
+
+        void Compile(Bytecode::Compiler &compiler) override;
+
     private:
         std::unique_ptr<Statement> statement;
     };
@@ -222,6 +312,8 @@ namespace Ast {
 
         ObjectHolder Execute(Runtime::Closure &closure) override;
 
+        void Compile(Bytecode::Compiler &compiler) override;
+
     private:
         ObjectHolder cls;
         const std::string &class_name;
@@ -237,6 +329,10 @@ namespace Ast {
 
         ObjectHolder Execute(Runtime::Closure &closure) override;
 
+        ObjectHolder ExecuteInBlock(Runtime::Closure &closure, Completion &completion) override;
+
+        void Compile(Bytecode::Compiler &compiler) override;
+
     private:
         std::unique_ptr<Statement> condition, if_body, else_body;
     };
@@ -251,10 +347,20 @@ namespace Ast {
                 std::unique_ptr<Statement> rhs
         );
 
+        // By the comparator of comparators.h of the kind
+        Comparison(
+                Runtime::ComparisonKind kind,
+                std::unique_ptr<Statement> lhs,
+                std::unique_ptr<Statement> rhs
+        );
+
         ObjectHolder Execute(Runtime::Closure &closure) override;
 
+        void Compile(Bytecode::Compiler &compiler) override;
+
     private:
         Comparator comparator;
+        std::optional<Runtime::ComparisonKind> kind;  // of the comparator, if it is of comparators.h
         std::unique_ptr<Statement> left, right;
     };
 
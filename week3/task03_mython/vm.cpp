@@ -0,0 +1,372 @@
+#include "vm.h"
+#include "object.h"
+#include "profiler.h"
+
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace Bytecode {
+
+    using Runtime::Closure;
+
+    namespace {
+        Closure::iterator FindVariable(Closure &closure, const string &name, bool as_field_assignment_object) {
+            auto it = closure.find(name);
+            if (it == closure.end()) {
+                if (as_field_assignment_object) {
+                    throw out_of_range("not found variable");
+                }
+                throw runtime_error("not found variable");
+            }
+            return it;
+        }
+
+        template<typename Holder>
+        auto &AsInstance(Holder &object) {
+            auto instance = object.template TryAs<Runtime::ClassInstance>();
+            if (instance == nullptr) {
+                throw runtime_error("vm.cpp not a class instance");
+            }
+            return *instance;
+        }
+    }
+
+    VirtualMachine::VirtualMachine(const Program &program, ostream &output)
+            : program_(program), output_(output), field_caches_(program.field_sites.size()),
+              method_caches_(program.call_sites.size()) {}
+
+    ObjectHolder VirtualMachine::Run(Closure &closure) {
+        const size_t frame_begin = stack_.size();
+        try {
+            return Execute(program_.main, &closure, frame_begin);
+        } catch (...) {
+            // What is left on the stack by the failed run is not to be kept until the next one
+            stack_.erase(stack_.begin() + frame_begin, stack_.end());
+            throw;
+        }
+    }
+
+    ObjectHolder &VirtualMachine::LoadField(Runtime::ClassInstance &instance, uint32_t field_site, bool as_field_assignment_object) {
+        auto &cache = field_caches_[field_site];
+        const Runtime::Shape &shape = instance.GetShape();
+        if (cache.shape != &shape) {
+            auto offset = shape.FindField(program_.names[program_.field_sites[field_site]]);
+            if (!offset) {
+                if (as_field_assignment_object) {
+                    throw out_of_range("not found variable");
+                }
+                throw runtime_error("not found variable");
+            }
+            cache = {&shape, *offset, nullptr};
+        }
+        return instance.GetField(cache.offset);
+    }
+
+    void VirtualMachine::StoreField(Runtime::ClassInstance &instance, uint32_t field_site, ObjectHolder value) {
+        auto &cache = field_caches_[field_site];
+        const Runtime::Shape &shape = instance.GetShape();
+        if (cache.shape != &shape) {
+            const string &name = program_.names[program_.field_sites[field_site]];
+            if (auto offset = shape.FindField(name)) {
+                cache = {&shape, *offset, nullptr};
+            } else {
+                cache = {&shape, shape.GetFieldCount(), &shape.AddField(name)};
+            }
+        }
+        if (cache.shape_with_field != nullptr) {
+            instance.AddField(*cache.shape_with_field, move(value));
+        } else {
+            instance.GetField(cache.offset) = move(value);
+        }
+    }
+
+    ObjectHolder VirtualMachine::Pop() {
+        ObjectHolder result = move(stack_.back());
+        stack_.pop_back();
+        return result;
+    }
+
+    void VirtualMachine::PushResult(ObjectHolder result) {
+        stack_.pop_back();
+        stack_.back() = move(result);
+    }
+
+    const Code *VirtualMachine::FindMethodCode(const Runtime::ClassInstance &instance, uint32_t call_site, size_t argument_count) {
+        auto &cache = method_caches_[call_site];
+        const Runtime::Class *cls = &instance.GetClass();
+        for (size_t i = 0; i < cache.size; i++) {
+            if (cache.classes[i] == cls) {
+                return cache.codes[i];
+            }
+        }
+
+        // The argument count of a call site is always the same, so is the method found for a class
+        const Runtime::Method *method = instance.FindMethod(program_.names[program_.call_sites[call_site]], argument_count);
+        const Code *code = method != nullptr ? &program_.GetMethodCode(*method) : nullptr;
+        if (cache.size < MethodCache::MAX_CLASSES) {
+            cache.classes[cache.size] = cls;
+            cache.codes[cache.size] = code;
+            cache.size++;
+        }
+        return code;
+    }
+
+    ObjectHolder VirtualMachine::CallMethod(size_t frame_begin, uint32_t call_site, size_t argument_count) {
+        const Code *code = FindMethodCode(AsInstance(stack_[frame_begin]), call_site, argument_count);
+        if (code == nullptr) {
+            throw runtime_error("ObjectHolder ClassInstance::Call " + program_.names[program_.call_sites[call_site]]);
+        }
+        return CallMethod(frame_begin, *code, call_site);
+    }
+
+    ObjectHolder VirtualMachine::CallMethod(size_t frame_begin, const Code &code, uint32_t call_site) {
+        Runtime::Profiler::MethodCall profiled_call(Runtime::Profiler::Current(), AsInstance(stack_[frame_begin]),
+                                                    program_.names[program_.call_sites[call_site]]);
+        stack_.resize(frame_begin + code.local_names.size());
+        return Execute(code, nullptr, frame_begin);
+    }
+
+    ObjectHolder VirtualMachine::CallOperator(uint32_t call_site, const char *error) {
+        const size_t frame_begin = stack_.size() - 2;
+        const Code *code = FindMethodCode(AsInstance(stack_[frame_begin]), call_site, 1);
+        if (code == nullptr) {
+            throw runtime_error(error);
+        }
+        return CallMethod(frame_begin, *code, call_site);
+    }
+
+    bool VirtualMachine::CallComparison(uint32_t call_site) {
+        const size_t frame_begin = stack_.size();
+        stack_.push_back(stack_[frame_begin - 2]);
+        stack_.push_back(stack_[frame_begin - 1]);
+        const Code *code = FindMethodCode(AsInstance(stack_[frame_begin]), call_site, 1);
+        if (code == nullptr) {
+            throw runtime_error("comparators.cpp CompareInstance [no " + program_.names[program_.call_sites[call_site]] + "]");
+        }
+        return Runtime::IsTrue(CallMethod(frame_begin, *code, call_site));
+    }
+
+    void VirtualMachine::PrintObject(ostream &os, ObjectHolder object, uint32_t call_site) {
+        if (auto instance = object.TryAs<Runtime::ClassInstance>(); instance != nullptr) {
+            // As ClassInstance::Print, the errors of __str__ itself print the address as well
+            const Code *code = FindMethodCode(*instance, call_site, 0);
+            if (code == nullptr) {
+                os << instance;
+                return;
+            }
+            const size_t stack_size = stack_.size();
+            try {
+                stack_.push_back(object);
+                PrintObject(os, CallMethod(stack_size, *code, call_site), call_site);
+            }
+            catch (const runtime_error &e) {
+                stack_.resize(stack_size);
+                os << instance;
+            }
+        } else {
+            object->Print(os);
+        }
+    }
+
+    ObjectHolder VirtualMachine::Execute(const Code &code, Closure *closure, size_t frame_begin) {
+        Runtime::Profiler *profiler = Runtime::Profiler::Current();
+        const Instruction *instructions = code.instructions.data();
+        for (const Instruction *ip = instructions;;) {
+            const Instruction &instruction = *ip++;
+            if (profiler != nullptr) {
+                profiler->OnInstruction();
+            }
+            switch (instruction.op) {
+                case OpCode::LOAD_CONST:
+                    stack_.push_back(program_.constants[instruction.arg]);
+                    break;
+                case OpCode::LOAD_NONE:
+                    stack_.push_back(ObjectHolder::None());
+                    break;
+                case OpCode::LOAD_NULL:
+                    stack_.emplace_back();
+                    break;
+                case OpCode::LOAD_VARIABLE:
+                    stack_.push_back(FindVariable(*closure, program_.names[instruction.arg], instruction.count)->second);
+                    break;
+                case OpCode::LOAD_LOCAL: {
+                    const ObjectHolder &variable = stack_[frame_begin + instruction.arg];
+                    if (!variable.Get()) {
+                        if (instruction.count) {
+                            throw out_of_range("not found variable");
+                        }
+                        throw runtime_error("not found variable");
+                    }
+                    stack_.push_back(variable);
+                    break;
+                }
+                case OpCode::LOAD_FIELD: {
+                    // Copied before the instance, which may own it, leaves the stack
+                    ObjectHolder field = LoadField(AsInstance(stack_.back()), instruction.arg, instruction.count);
+                    stack_.back() = move(field);
+                    break;
+                }
+                case OpCode::STORE_VARIABLE: {
+                    auto &variable = (*closure)[program_.names[instruction.arg]];
+                    if (instruction.count) {
+                        variable = stack_.back();
+                    } else {
+                        variable = Pop();
+                    }
+                    break;
+                }
+                case OpCode::STORE_LOCAL:
+                    if (instruction.count) {
+                        stack_[frame_begin + instruction.arg] = stack_.back();
+                    } else {
+                        stack_[frame_begin + instruction.arg] = Pop();
+                    }
+                    break;
+                case OpCode::STORE_FIELD: {
+                    ObjectHolder value = Pop();
+                    ObjectHolder object = Pop();
+                    if (instruction.count) {
+                        stack_.push_back(value);
+                    }
+                    StoreField(AsInstance(object), instruction.arg, move(value));
+                    break;
+                }
+                case OpCode::POP:
+                    stack_.pop_back();
+                    break;
+                case OpCode::PRINT:
+                    PrintObject(output_, Pop(), instruction.arg);
+                    break;
+                case OpCode::PRINT_SPACE:
+                    output_ << ' ';
+                    break;
+                case OpCode::PRINT_NEWLINE:
+                    output_ << '\n';
+                    break;
+                case OpCode::STRINGIFY: {
+                    ostringstream os;
+                    PrintObject(os, Pop(), instruction.arg);
+                    stack_.push_back(ObjectHolder::Own(Runtime::String(os.str())));
+                    break;
+                }
+                case OpCode::ADD: {
+                    const ObjectHolder &lhs = stack_[stack_.size() - 2], &rhs = stack_.back();
+                    if (auto lhs_str_ptr = lhs.TryAs<Runtime::String>(); lhs_str_ptr != nullptr) {
+                        auto rhs_str_ptr = rhs.TryAs<Runtime::String>();
+                        if (rhs_str_ptr == nullptr) { throw runtime_error("statement.cpp Add::Execute [str + not_str]"); }
+                        PushResult(ObjectHolder::Own(Runtime::String(lhs_str_ptr->GetValue() + rhs_str_ptr->GetValue())));
+                    } else if (auto lhs_num_ptr = lhs.TryAs<Runtime::Number>(); lhs_num_ptr != nullptr) {
+                        auto rhs_num_ptr = rhs.TryAs<Runtime::Number>();
+                        if (rhs_num_ptr == nullptr) { throw runtime_error("statement.cpp Add::Execute [num + not_num]"); }
+                        PushResult(ObjectHolder::Own(Runtime::Number(lhs_num_ptr->GetValue() + rhs_num_ptr->GetValue())));
+                    } else if (lhs.TryAs<Runtime::ClassInstance>() != nullptr) {
+                        ObjectHolder result = CallOperator(instruction.arg, "statement.cpp Add::Execute [inst wo __add__()]");
+                        stack_.push_back(move(result));
+                    } else {
+                        throw runtime_error("statement.cpp Add::Execute");
+                    }
+                    break;
+                }
+                case OpCode::SUB:
+                case OpCode::MULT:
+                case OpCode::DIV: {
+                    const ObjectHolder &lhs = stack_[stack_.size() - 2], &rhs = stack_.back();
+                    auto lhs_num_ptr = lhs.TryAs<Runtime::Number>(), rhs_num_ptr = rhs.TryAs<Runtime::Number>();
+                    if (lhs_num_ptr != nullptr && rhs_num_ptr != nullptr) {
+                        const int l = lhs_num_ptr->GetValue(), r = rhs_num_ptr->GetValue();
+                        const int result = instruction.op == OpCode::SUB ? l - r : instruction.op == OpCode::MULT ? l * r : l / r;
+                        PushResult(ObjectHolder::Own(Runtime::Number(result)));
+                    } else if (lhs.TryAs<Runtime::ClassInstance>() != nullptr) {
+                        ObjectHolder result;
+                        if (instruction.op == OpCode::SUB) {
+                            result = CallOperator(instruction.arg, "statement.cpp Sub::Execute [inst wo __sub__()]");
+                        } else if (instruction.op == OpCode::MULT) {
+                            result = CallOperator(instruction.arg, "statement.cpp Mul::Execute [inst wo __mul__()]");
+                        } else {
+                            result = CallOperator(instruction.arg, "statement.cpp Div::Execute [inst wo __div__()]");
+                        }
+                        stack_.push_back(move(result));
+                    } else {
+                        throw runtime_error(instruction.op == OpCode::SUB ? "statement.cpp Sub::Execute"
+                                                                  : instruction.op == OpCode::MULT ? "statement.cpp Mult::Execute"
+                                                                                           : "statement.cpp Div::Execute");
+                    }
+                    break;
+                }
+                case OpCode::OR: {
+                    ObjectHolder rhs = Pop(), lhs = Pop();
+                    stack_.push_back(ObjectHolder::Own(Runtime::Bool(Runtime::IsTrue(lhs) || Runtime::IsTrue(rhs))));
+                    break;
+                }
+                case OpCode::AND: {
+                    ObjectHolder rhs = Pop(), lhs = Pop();
+                    stack_.push_back(ObjectHolder::Own(Runtime::Bool(Runtime::IsTrue(lhs) && Runtime::IsTrue(rhs))));
+                    break;
+                }
+                case OpCode::NOT:
+                    stack_.back() = ObjectHolder::Own(Runtime::Bool(!Runtime::IsTrue(stack_.back())));
+                    break;
+                case OpCode::COMPARE: {
+                    const ComparisonSite &site = program_.comparisons[instruction.arg];
+                    const ObjectHolder &lhs = stack_[stack_.size() - 2], &rhs = stack_.back();
+                    bool result;
+                    if (site.kind && lhs.TryAs<Runtime::ClassInstance>() != nullptr) {
+                        result = Runtime::Compare(*site.kind, [&] { return CallComparison(site.equal_call_site); },
+                                                  [&] { return CallComparison(site.less_call_site); });
+                    } else {
+                        result = (*site.comparator)(lhs, rhs);
+                    }
+                    PushResult(ObjectHolder::Own(Runtime::Bool(result)));
+                    break;
+                }
+                case OpCode::CALL_METHOD: {
+                    ObjectHolder result = CallMethod(stack_.size() - instruction.count - 1, instruction.arg, instruction.count);
+                    stack_.push_back(move(result));
+                    break;
+                }
+                case OpCode::NEW_INSTANCE:
+                    stack_.push_back(ObjectHolder::Own(Runtime::ClassInstance(*program_.classes[instruction.arg])));
+                    if (profiler != nullptr) {
+                        profiler->OnNewInstance(*stack_.back().TryAs<Runtime::ClassInstance>());
+                    }
+                    break;
+                case OpCode::CALL_INIT: {
+                    const size_t instance_index = stack_.size() - instruction.count - 1;
+                    ObjectHolder instance = stack_[instance_index];
+                    CallMethod(instance_index, instruction.arg, instruction.count);
+                    stack_.push_back(move(instance));
+                    break;
+                }
+                case OpCode::DEFINE_CLASS: {
+                    const ObjectHolder &cls = program_.constants[instruction.arg];
+                    closure->insert({cls.TryAs<Runtime::Class>()->GetName(), cls});
+                    stack_.push_back(cls);
+                    break;
+                }
+                case OpCode::DEFINE_LOCAL: {
+                    auto &variable = stack_[frame_begin + instruction.arg];
+                    if (!variable.Get()) {
+                        variable = stack_.back();
+                    }
+                    break;
+                }
+                case OpCode::JUMP:
+                    ip = instructions + instruction.arg;
+                    break;
+                case OpCode::JUMP_IF_FALSE:
+                    if (!Runtime::IsTrue(Pop())) {
+                        ip = instructions + instruction.arg;
+                    }
+                    break;
+                case OpCode::RETURN: {
+                    ObjectHolder result = Pop();
+                    stack_.resize(frame_begin);
+                    return result;
+                }
+            }
+        }
+    }
+
+} /* namespace Bytecode */
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "bytecode.h"
+#include "object_holder.h"
+
+#include <array>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Bytecode {
+
+    // Runs a compiled program the way the tree of it is executed
+    class VirtualMachine {
+    public:
+        VirtualMachine(const Program &program, std::ostream &output);
+
+        // Runs the main code with the variables of the closure, returns its result. The VM may run it again,
+        // with the caches of the previous runs
+        ObjectHolder Run(Runtime::Closure &closure);
+
+    private:
+        // The frame of the code starts at frame_begin of the stack, closure is for the top-level code only.
+        // Leaves the stack up to frame_begin
+        ObjectHolder Execute(const Code &code, Runtime::Closure *closure, size_t frame_begin);
+
+        // Of the method of the call site, nullptr if the class of the instance has no such method of the argument count
+        const Code *FindMethodCode(const Runtime::ClassInstance &instance, uint32_t call_site, size_t argument_count);
+
+        // The instance is at frame_begin of the stack and the arguments are after it, they become the frame of the method
+        ObjectHolder CallMethod(size_t frame_begin, uint32_t call_site, size_t argument_count);
+
+        // Of the method found for the call site
+        ObjectHolder CallMethod(size_t frame_begin, const Code &code, uint32_t call_site);
+
+        // Calls the arithmetic method of the instance under the top with the top
+        ObjectHolder CallOperator(uint32_t call_site, const char *error);
+
+        // Whether the result of __eq__ or __lt__ of the instance under the top with the top is true, keeps them
+        bool CallComparison(uint32_t call_site);
+
+        // The call site is of __str__
+        void PrintObject(std::ostream &os, ObjectHolder object, uint32_t call_site);
+
+        // Of a call site: the methods found for the classes of the instances called there, up to MAX_CLASSES of them
+        struct MethodCache {
+            static constexpr size_t MAX_CLASSES = 4;
+
+            std::array<const Runtime::Class *, MAX_CLASSES> classes{};
+            std::array<const Code *, MAX_CLASSES> codes{};  // nullptr if the class has no method to call
+            size_t size = 0;
+        };
+
+        // Offset of the field in the instances of the shape
+        struct FieldCache {
+            const Runtime::Shape *shape = nullptr;
+            size_t offset = 0;
+            const Runtime::Shape *shape_with_field = nullptr;  // if the field is added to the instances of the shape
+        };
+
+        ObjectHolder &LoadField(Runtime::ClassInstance &instance, uint32_t field_site, bool as_field_assignment_object);
+
+        void StoreField(Runtime::ClassInstance &instance, uint32_t field_site, ObjectHolder value);
+
+        ObjectHolder Pop();
+
+        // Pops the operands of a binary operation
+        void PushResult(ObjectHolder result);
+
+        const Program &program_;
+        std::ostream &output_;
+        std::vector<ObjectHolder> stack_;
+        std::vector<FieldCache> field_caches_;  // by field sites
+        std::vector<MethodCache> method_caches_;  // by call sites
+    };
+
+} /* namespace Bytecode */
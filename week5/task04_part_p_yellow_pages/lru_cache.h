@@ -0,0 +1,86 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+
+struct LruCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+};
+
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+public:
+    using Stats = LruCacheStats;
+
+    explicit LruCache(size_t capacity) : capacity_(capacity) {}
+
+    std::optional<Value> Get(const Key &key);
+
+    void Put(Key key, Value value);
+
+    size_t GetSize() const;
+
+    Stats GetStats() const;
+
+private:
+    using Entries = std::list<std::pair<Key, Value>>;
+
+    const size_t capacity_;  // 0 disables caching
+
+    mutable std::mutex mutex_;
+    Entries entries_;  // most recently used first
+    std::unordered_map<Key, typename Entries::iterator, Hash> entry_by_key_;
+    Stats stats_;
+};
+
+
+template<typename Key, typename Value, typename Hash>
+std::optional<Value> LruCache<Key, Value, Hash>::Get(const Key &key) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = entry_by_key_.find(key);
+    if (it == entry_by_key_.end()) {
+        ++stats_.misses;
+        return std::nullopt;
+    }
+    ++stats_.hits;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->second;
+}
+
+template<typename Key, typename Value, typename Hash>
+void LruCache<Key, Value, Hash>::Put(Key key, Value value) {
+    if (capacity_ == 0) { return; }
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (auto it = entry_by_key_.find(key); it != entry_by_key_.end()) {  // put by a concurrent miss on the same key
+        it->second->second = std::move(value);
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return;
+    }
+
+    if (entries_.size() == capacity_) {
+        entry_by_key_.erase(entries_.back().first);
+        entries_.pop_back();
+        ++stats_.evictions;
+    }
+    entries_.emplace_front(key, std::move(value));
+    entry_by_key_.emplace(std::move(key), entries_.begin());
+}
+
+template<typename Key, typename Value, typename Hash>
+size_t LruCache<Key, Value, Hash>::GetSize() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return entries_.size();
+}
+
+template<typename Key, typename Value, typename Hash>
+LruCacheStats LruCache<Key, Value, Hash>::GetStats() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return stats_;
+}
@@ -1,5 +1,9 @@
 #include "map_renderer.h"
 
+#include <future>
+#include <mutex>
+#include <numeric>
+
 
 using namespace std;
 
@@ -24,6 +28,17 @@ RenderSettings::RenderSettings(const Json::Dict &render_settings_json) {
         layers.push_back(l_node.AsString());
     }
     outer_margin = render_settings_json.at("outer_margin").AsDouble();
+    if (render_settings_json.count("svg_precision")) {
+        const int precision = render_settings_json.at("svg_precision").AsInt();
+        if (precision < 0 || precision > Svg::RenderOptions::MAX_PRECISION) {
+            throw invalid_argument("RenderSettings: svg_precision " + to_string(precision) + " is not in 0.."
+                                   + to_string(Svg::RenderOptions::MAX_PRECISION));
+        }
+        svg_render_options.precision = precision;
+    }
+    if (render_settings_json.count("svg_minified")) {
+        svg_render_options.minified = render_settings_json.at("svg_minified").AsBool();
+    }
 }
 
 
@@ -173,67 +188,125 @@ Svg::Point PointConverterFlattenCompress::operator()(Sphere::Point to_convert) c
 
 
 // ===========================================================================================================================================
-// ========================================================= PointConverterFlattenCompressRoutes =======================================================
+// ========================================================= Stop ids and adjacency ==========================================================
 // ===========================================================================================================================================
 
-PointConverterFlattenCompressRoutes::PointConverterFlattenCompressRoutes() {}
+namespace {
+    // Dense ids: stops are numbered in stop_coords order, distinct coordinates in Sphere::PointLess order
+    struct StopsIdIndex {
+        explicit StopsIdIndex(const std::map<std::string, Sphere::Point> &stop_coords) {
+            stop_ids.reserve(stop_coords.size());
+            stop_points.reserve(stop_coords.size());
+            for (const auto&[stop_name, stop_point] : stop_coords) {
+                stop_ids.emplace(stop_name, stop_points.size());
+                stop_points.push_back(stop_point);
+            }
 
-PointConverterFlattenCompressRoutes::PointConverterFlattenCompressRoutes(const std::map<std::string, Sphere::Point> &stop_coords, const Descriptions::BusesDict &buses_dict,
-                                                                         const RenderSettings &renderSettings) {
-    // adjacent stops
-    unordered_map<string, unordered_set<string>> adjacent_stops;
-    for (const auto&[bus_name, desc_bus] : buses_dict) {
-        for (auto[it_prev, it_next] = make_tuple(desc_bus->stops.begin(), next(desc_bus->stops.begin())); it_next != desc_bus->stops.end(); it_prev++, it_next++) {
-            adjacent_stops[*it_prev].insert(*it_next);
-            adjacent_stops[*it_next].insert(*it_prev);
+            sorted_points = stop_points;
+            sort(sorted_points.begin(), sorted_points.end(), Sphere::PointLess{});
+            sorted_points.erase(unique(sorted_points.begin(), sorted_points.end()), sorted_points.end());
+
+            stop_point_ids.reserve(stop_points.size());
+            for (const auto &stop_point : stop_points) {
+                stop_point_ids.push_back(lower_bound(sorted_points.begin(), sorted_points.end(), stop_point, Sphere::PointLess{}) - sorted_points.begin());
+            }
         }
-    }
 
-    padding = renderSettings.padding;
-    height = renderSettings.height;
+        vector<size_t> GetBusStopIds(const Descriptions::Bus &bus) const {
+            vector<size_t> bus_stop_ids;
+            bus_stop_ids.reserve(bus.stops.size());
+            for (const auto &stop_name : bus.stops) {
+                bus_stop_ids.push_back(stop_ids.at(stop_name));
+            }
+            return bus_stop_ids;
+        }
 
-    std::vector<pair<std::string, Sphere::Point>> x_stops_sorted(stop_coords.begin(), stop_coords.end()), y_stops_sorted(stop_coords.begin(), stop_coords.end());
-    sort(x_stops_sorted.begin(), x_stops_sorted.end(),
-         [](const pair<std::string, Sphere::Point> &lhs, const pair<std::string, Sphere::Point> &rhs) { return lhs.second.longitude < rhs.second.longitude; });
-    sort(y_stops_sorted.begin(), y_stops_sorted.end(),
-         [](const pair<std::string, Sphere::Point> &lhs, const pair<std::string, Sphere::Point> &rhs) { return lhs.second.latitude < rhs.second.latitude; });
+        unordered_map<string_view, size_t> stop_ids;
+        vector<Sphere::Point> stop_points;  // by stop id
+        vector<size_t> stop_point_ids;  // by stop id, index in sorted_points
+        vector<Sphere::Point> sorted_points;
+    };
 
-    int max_idx_x = 0, max_idx_y = 0;
-    for (const auto&[stop_name, stop_point] : x_stops_sorted) {
-        auto adj_it = adjacent_stops.find(stop_name);
-        if (adj_it == adjacent_stops.end()) {  // if not adjacent
-            x_stop_coord_idx[stop_coords.at(stop_name)] = 0;
-            continue;
-        }
+    // Stops adjacent on any bus, in CSR form: neighbours of stop s are neighbours[offsets[s]..offsets[s + 1])
+    struct StopsAdjacency {
+        StopsAdjacency(const StopsIdIndex &index, const Descriptions::BusesDict &buses_dict) : offsets(index.stop_points.size() + 1, 0) {
+            vector<pair<size_t, size_t>> edges;
+            for (const auto&[bus_name, desc_bus] : buses_dict) {
+                const vector<size_t> bus_stop_ids = index.GetBusStopIds(*desc_bus);
+                for (size_t i = 1; i < bus_stop_ids.size(); ++i) {
+                    edges.emplace_back(bus_stop_ids[i - 1], bus_stop_ids[i]);
+                    edges.emplace_back(bus_stop_ids[i], bus_stop_ids[i - 1]);
+                }
+            }
+            sort(edges.begin(), edges.end());
+            edges.erase(unique(edges.begin(), edges.end()), edges.end());
 
-        int max_idx = -1;
-        for (const string &adj_stop : adj_it->second) {
-            auto it = x_stop_coord_idx.find(stop_coords.at(adj_stop));
-            if (it != x_stop_coord_idx.end() && it->second > max_idx) {
-                max_idx = it->second;
+            neighbours.reserve(edges.size());
+            for (const auto&[stop_from, stop_to] : edges) {
+                ++offsets[stop_from + 1];
+                neighbours.push_back(stop_to);
             }
+            partial_sum(offsets.begin(), offsets.end(), offsets.begin());
         }
-        x_stop_coord_idx[stop_coords.at(stop_name)] = max_idx + 1;  // or (-1) + 1 == 0
-        max_idx_x = max(max_idx_x, max_idx + 1);
-    }
 
-    for (const auto&[stop_name, stop_point] : y_stops_sorted) {
-        auto adj_it = adjacent_stops.find(stop_name);
-        if (adj_it == adjacent_stops.end()) {  // if not adjacent
-            y_stop_coord_idx[stop_coords.at(stop_name)] = 0;
-            continue;
+        Range<vector<size_t>::const_iterator> GetNeighbours(size_t stop_id) const {
+            return {neighbours.begin() + offsets[stop_id], neighbours.begin() + offsets[stop_id + 1]};
         }
 
-        int max_idx = -1;
-        for (const string &adj_stop : adj_it->second) {
-            auto it = y_stop_coord_idx.find(stop_coords.at(adj_stop));
-            if (it != y_stop_coord_idx.end() && it->second > max_idx) {
-                max_idx = it->second;
+        vector<size_t> offsets;
+        vector<size_t> neighbours;
+    };
+
+    // Single sweep over stops in coordinate order: a stop gets the index next to the maximal one already assigned
+    // to coords of its neighbours, or 0 if it has no neighbours. Indices are kept per distinct coords, as stops sharing coords share a point.
+    template<typename GetCoord>
+    vector<int> AssignCompressedIndices(const StopsIdIndex &index, const StopsAdjacency &adjacency, GetCoord get_coord, int &max_idx) {
+        vector<size_t> stops_sorted(index.stop_points.size());
+        iota(stops_sorted.begin(), stops_sorted.end(), 0);
+        sort(stops_sorted.begin(), stops_sorted.end(),
+             [&index, &get_coord](size_t lhs, size_t rhs) { return get_coord(index.stop_points[lhs]) < get_coord(index.stop_points[rhs]); });
+
+        vector<int> point_idx(index.sorted_points.size(), -1);
+        max_idx = 0;
+        for (const size_t stop_id : stops_sorted) {
+            int max_adjacent_idx = -1;
+            for (const size_t adjacent_stop_id : adjacency.GetNeighbours(stop_id)) {
+                max_adjacent_idx = max(max_adjacent_idx, point_idx[index.stop_point_ids[adjacent_stop_id]]);
             }
+            point_idx[index.stop_point_ids[stop_id]] = max_adjacent_idx + 1;  // or (-1) + 1 == 0, also for stops without neighbours
+            max_idx = max(max_idx, max_adjacent_idx + 1);
+        }
+        return point_idx;
+    }
+
+    optional<size_t> FindSortedPoint(const vector<Sphere::Point> &sorted_points, Sphere::Point point) {
+        auto it = lower_bound(sorted_points.begin(), sorted_points.end(), point, Sphere::PointLess{});
+        if (it == sorted_points.end() || !(*it == point)) {
+            return nullopt;
         }
-        y_stop_coord_idx[stop_coords.at(stop_name)] = max_idx + 1;  // or (-1) + 1 == 0
-        max_idx_y = max(max_idx_y, max_idx + 1);
+        return it - sorted_points.begin();
     }
+}
+
+
+// ===========================================================================================================================================
+// ========================================================= PointConverterFlattenCompressRoutes =======================================================
+// ===========================================================================================================================================
+
+PointConverterFlattenCompressRoutes::PointConverterFlattenCompressRoutes() {}
+
+PointConverterFlattenCompressRoutes::PointConverterFlattenCompressRoutes(const std::map<std::string, Sphere::Point> &stop_coords, const Descriptions::BusesDict &buses_dict,
+                                                                         const RenderSettings &renderSettings) {
+    const StopsIdIndex index(stop_coords);
+    const StopsAdjacency adjacency(index, buses_dict);
+
+    padding = renderSettings.padding;
+    height = renderSettings.height;
+
+    int max_idx_x = 0, max_idx_y = 0;
+    x_coord_idx = AssignCompressedIndices(index, adjacency, [](Sphere::Point p) { return p.longitude; }, max_idx_x);
+    y_coord_idx = AssignCompressedIndices(index, adjacency, [](Sphere::Point p) { return p.latitude; }, max_idx_y);
+    sorted_points = index.sorted_points;
 
     x_step = max_idx_x == 0 ? 0 : (renderSettings.width - 2 * renderSettings.padding) / static_cast<double>(max_idx_x);
     y_step = max_idx_y == 0 ? 0 : (renderSettings.height - 2 * renderSettings.padding) / static_cast<double>(max_idx_y);
@@ -246,17 +319,23 @@ PointConverterFlattenCompressRoutes::PointConverterFlattenCompressRoutes(const S
     x_step = serialization_converter.x_step();
     y_step = serialization_converter.y_step();
 
-    for (int i = 0; i < serialization_converter.x_stop_coord_idx_from_size(); ++i) {
-        x_stop_coord_idx[{serialization_converter.x_stop_coord_idx_from(i).x(), serialization_converter.x_stop_coord_idx_from(i).y()}] = serialization_converter.x_stop_coord_idx_to(i);
+    sorted_points.reserve(serialization_converter.sorted_points_size());
+    for (int i = 0; i < serialization_converter.sorted_points_size(); ++i) {
+        sorted_points.push_back({serialization_converter.sorted_points(i).x(), serialization_converter.sorted_points(i).y()});
     }
-
-    for (int i = 0; i < serialization_converter.y_stop_coord_idx_from_size(); ++i) {
-        y_stop_coord_idx[{serialization_converter.y_stop_coord_idx_from(i).x(), serialization_converter.y_stop_coord_idx_from(i).y()}] = serialization_converter.y_stop_coord_idx_to(i);
+    x_coord_idx.assign(serialization_converter.x_coord_idx().begin(), serialization_converter.x_coord_idx().end());
+    y_coord_idx.assign(serialization_converter.y_coord_idx().begin(), serialization_converter.y_coord_idx().end());
+    if (x_coord_idx.size() != sorted_points.size() || y_coord_idx.size() != sorted_points.size()) {
+        throw invalid_argument("PointConverterFlattenCompressRoutes: the indices are not parallel to the points");
     }
 }
 
 Svg::Point PointConverterFlattenCompressRoutes::operator()(Sphere::Point to_convert) const {
-    return {this->x_stop_coord_idx.at(to_convert) * x_step + padding, height - padding - this->y_stop_coord_idx.at(to_convert) * y_step};
+    const auto point_idx = FindSortedPoint(sorted_points, to_convert);
+    if (!point_idx) {
+        throw out_of_range("PointConverterFlattenCompressRoutes::operator()(Sphere::Point to_convert)");
+    }
+    return {x_coord_idx[*point_idx] * x_step + padding, height - padding - y_coord_idx[*point_idx] * y_step};
 }
 
 Serialization::PointConverterFlattenCompressRoutes PointConverterFlattenCompressRoutes::SerializeConverter() const {
@@ -267,22 +346,13 @@ Serialization::PointConverterFlattenCompressRoutes PointConverterFlattenCompress
     serialization_converter.set_x_step(x_step);
     serialization_converter.set_y_step(y_step);
 
-    for (const auto&[p, idx] : x_stop_coord_idx) {
-        Serialization::Point &serialization_cur_point = *serialization_converter.add_x_stop_coord_idx_from();
+    for (const auto &p : sorted_points) {
+        Serialization::Point &serialization_cur_point = *serialization_converter.add_sorted_points();
         serialization_cur_point.set_x(p.latitude);
         serialization_cur_point.set_y(p.longitude);
-
-        serialization_converter.add_x_stop_coord_idx_to(idx);
-    }
-
-
-    for (const auto&[p, idx] : y_stop_coord_idx) {
-        Serialization::Point &serialization_cur_point = *serialization_converter.add_y_stop_coord_idx_from();
-        serialization_cur_point.set_x(p.latitude);
-        serialization_cur_point.set_y(p.longitude);
-
-        serialization_converter.add_y_stop_coord_idx_to(idx);
     }
+    *serialization_converter.mutable_x_coord_idx() = {x_coord_idx.begin(), x_coord_idx.end()};
+    *serialization_converter.mutable_y_coord_idx() = {y_coord_idx.begin(), y_coord_idx.end()};
 
     return serialization_converter;
 }
@@ -295,72 +365,103 @@ Serialization::PointConverterFlattenCompressRoutes PointConverterFlattenCompress
 PointConverterIntermediateStops::PointConverterIntermediateStops() {}
 
 PointConverterIntermediateStops::PointConverterIntermediateStops(const std::map<std::string, Sphere::Point> &stop_coords, const Descriptions::BusesDict &buses_dict) {
-    unordered_set<string> bearing_stops;
+    const StopsIdIndex index(stop_coords);
+
+    vector<vector<size_t>> buses_stop_ids;
+    buses_stop_ids.reserve(buses_dict.size());
+    for (const auto&[bus_name, desc_bus] : buses_dict) {
+        buses_stop_ids.push_back(index.GetBusStopIds(*desc_bus));
+    }
+
+    vector<bool> is_bearing_stop(index.stop_points.size(), false);
 
     // ending stations
+    size_t bus_idx = 0;
     for (const auto&[bus_name, desc_bus] : buses_dict) {
-        bearing_stops.insert(desc_bus->stops.front());
-        if (!desc_bus->is_roundtrip) { bearing_stops.insert(desc_bus->stops.at(desc_bus->stops.size() / 2)); }
+        const vector<size_t> &bus_stop_ids = buses_stop_ids[bus_idx++];
+        is_bearing_stop[bus_stop_ids.front()] = true;
+        if (!desc_bus->is_roundtrip) { is_bearing_stop[bus_stop_ids.at(bus_stop_ids.size() / 2)] = true; }
     }
 
     // transfer stop
-    unordered_map<string, vector<string>> buses_by_stop;
-    for (const auto&[bus_name, desc_bus] : buses_dict) {
-        for (const string &stop_in_bus : desc_bus->stops) {
-            buses_by_stop[stop_in_bus].push_back(bus_name);
+    vector<size_t> stop_visits_count(index.stop_points.size(), 0), stop_buses_count(index.stop_points.size(), 0);
+    vector<size_t> stop_last_bus(index.stop_points.size(), buses_stop_ids.size());
+    for (bus_idx = 0; bus_idx < buses_stop_ids.size(); ++bus_idx) {
+        for (const size_t stop_id : buses_stop_ids[bus_idx]) {
+            ++stop_visits_count[stop_id];
+            if (stop_last_bus[stop_id] != bus_idx) {
+                stop_last_bus[stop_id] = bus_idx;
+                ++stop_buses_count[stop_id];
+            }
         }
     }
-    for (const auto&[stop_name, buses_stopping] : buses_by_stop) {
-        if (unordered_set(buses_stopping.begin(), buses_stopping.end()).size() > 1 || buses_stopping.size() > 2) {
-            bearing_stops.insert(stop_name);
+    for (size_t stop_id = 0; stop_id < index.stop_points.size(); ++stop_id) {
+        if (stop_buses_count[stop_id] > 1 || stop_visits_count[stop_id] > 2) {
+            is_bearing_stop[stop_id] = true;
         }
     }
 
     // mapping
-    for (const auto&[bus_name, desc_bus] : buses_dict) {
+    vector<optional<Sphere::Point>> mapping(index.sorted_points.size());
+    for (const vector<size_t> &bus_stop_ids : buses_stop_ids) {
+        auto stop_point = [&index, &bus_stop_ids](int idx_in_bus) { return index.stop_points[bus_stop_ids.at(idx_in_bus)]; };
+        auto mapped_point = [&index, &bus_stop_ids, &mapping](int idx_in_bus) -> optional<Sphere::Point> & {
+            return mapping[index.stop_point_ids[bus_stop_ids.at(idx_in_bus)]];
+        };
+
         int prev_bearing = 0;
-        mapping[stop_coords.at(desc_bus->stops.at(0))] = stop_coords.at(desc_bus->stops.at(0));
-        for (int next_bearing = 1; next_bearing < desc_bus->stops.size(); next_bearing++) {
-            if (bearing_stops.count(desc_bus->stops.at(next_bearing))) {
-                double lon_step = (stop_coords.at(desc_bus->stops.at(next_bearing)).longitude - stop_coords.at(desc_bus->stops.at(prev_bearing)).longitude) / (next_bearing - prev_bearing);
-                double lat_step = (stop_coords.at(desc_bus->stops.at(next_bearing)).latitude - stop_coords.at(desc_bus->stops.at(prev_bearing)).latitude) / (next_bearing - prev_bearing);
+        mapped_point(0) = stop_point(0);
+        for (int next_bearing = 1; next_bearing < static_cast<int>(bus_stop_ids.size()); next_bearing++) {
+            if (is_bearing_stop[bus_stop_ids[next_bearing]]) {
+                double lon_step = (stop_point(next_bearing).longitude - stop_point(prev_bearing).longitude) / (next_bearing - prev_bearing);
+                double lat_step = (stop_point(next_bearing).latitude - stop_point(prev_bearing).latitude) / (next_bearing - prev_bearing);
                 for (int i = prev_bearing + 1; i <= next_bearing; i++) {
-                    mapping[stop_coords.at(desc_bus->stops.at(i))] = {
-                            stop_coords.at(desc_bus->stops.at(prev_bearing)).latitude + lat_step * (i - prev_bearing),
-                            stop_coords.at(desc_bus->stops.at(prev_bearing)).longitude + lon_step * (i - prev_bearing)
+                    mapped_point(i) = Sphere::Point{
+                            stop_point(prev_bearing).latitude + lat_step * (i - prev_bearing),
+                            stop_point(prev_bearing).longitude + lon_step * (i - prev_bearing)
                     };
                     prev_bearing = next_bearing;
                 }
             }
         }
     }
+
+    for (size_t point_id = 0; point_id < mapping.size(); ++point_id) {
+        if (mapping[point_id]) {
+            points_from.push_back(index.sorted_points[point_id]);
+            points_to.push_back(*mapping[point_id]);
+        }
+    }
 }
 
 PointConverterIntermediateStops::PointConverterIntermediateStops(const Serialization::PointConverterIntermediateStops &serialization_converter) {
+    points_from.reserve(serialization_converter.points_from_size());
+    points_to.reserve(serialization_converter.points_to_size());
     for (int i = 0; i < serialization_converter.points_from_size(); ++i) {
-        mapping[{serialization_converter.points_from(i).x(), serialization_converter.points_from(i).y()}] = {serialization_converter.points_to(i).x(), serialization_converter.points_to(i).y()};
+        points_from.push_back({serialization_converter.points_from(i).x(), serialization_converter.points_from(i).y()});
+        points_to.push_back({serialization_converter.points_to(i).x(), serialization_converter.points_to(i).y()});
     }
 }
 
 Sphere::Point PointConverterIntermediateStops::operator()(Sphere::Point to_convert) const {
-    auto it = mapping.find(to_convert);
-    if (it == mapping.end()) {
+    const auto point_idx = FindSortedPoint(points_from, to_convert);
+    if (!point_idx) {
         return to_convert;  // stop without buses
     }
-    return it->second;
+    return points_to[*point_idx];
 }
 
 Serialization::PointConverterIntermediateStops PointConverterIntermediateStops::SerializeConverter() const {
     Serialization::PointConverterIntermediateStops serialization_converter;
 
-    for (const auto&[p_from, p_to] : mapping) {
+    for (size_t i = 0; i < points_from.size(); ++i) {
         Serialization::Point &serialization_point_from = *serialization_converter.add_points_from();
-        serialization_point_from.set_x(p_from.latitude);
-        serialization_point_from.set_y(p_from.longitude);
+        serialization_point_from.set_x(points_from[i].latitude);
+        serialization_point_from.set_y(points_from[i].longitude);
 
         Serialization::Point &serialization_point_to = *serialization_converter.add_points_to();
-        serialization_point_to.set_x(p_to.latitude);
-        serialization_point_to.set_y(p_to.longitude);
+        serialization_point_to.set_x(points_to[i].latitude);
+        serialization_point_to.set_y(points_to[i].longitude);
     }
 
     return serialization_converter;
@@ -422,7 +523,8 @@ MapRenderer::MapRenderer(const Descriptions::StopsDict &stops_dict, const Descri
         color_idx = color_idx + 1 == render_settings.color_palette.size() ? 0 : color_idx + 1;
     }
 
-    built_base_map_document = BuildBaseMap();
+    IndexStops();
+    CompileRenderPlan();
 }
 
 MapRenderer::MapRenderer(const Serialization::MapRenderer &serialization_renderer) {
@@ -459,27 +561,99 @@ MapRenderer::MapRenderer(const Serialization::MapRenderer &serialization_rendere
         bus_line_colors[serialization_renderer.bus_line_colors(idx).bus_name()] = serialization_renderer.bus_line_colors(idx).color_idx();
     }
 
-    built_base_map_document = BuildBaseMap();
+    IndexStops();
+    CompileRenderPlan();
 }
 
-void MapRenderer::RenderMapInplace(Svg::Document &doc) const {
+namespace {
+    // Route overlays below this many drawn stops are cheaper to render than to hand over to the render pool
+    const size_t PARALLEL_ROUTE_RENDER_MIN_STOPS = 64;
+
+    // Renders the layers on the pool if one is given, otherwise on the calling thread
+    template<typename DrawLayerFunc>
+    string RenderLayersToString(size_t layer_count, DrawLayerFunc draw_layer, ThreadPool *pool, const Svg::RenderOptions &svg_options) {
+        auto render_layer = [&draw_layer, &svg_options](size_t layer_idx) {
+            Svg::Document layer_doc;
+            draw_layer(layer_idx, layer_doc);
+            stringstream ss;
+            layer_doc.RenderObjects(ss, svg_options);
+            return ss.str();
+        };
+
+        vector<string> layer_buffers(layer_count);
+        if (pool) {
+            vector<future<string>> layer_futures;
+            layer_futures.reserve(layer_count);
+            for (size_t layer_idx = 0; layer_idx < layer_count; ++layer_idx) {
+                layer_futures.push_back(pool->Submit([&render_layer, layer_idx] { return render_layer(layer_idx); }));
+            }
+            // The jobs refer to this frame, so all of them finish before any exception is rethrown
+            for (auto &layer_future : layer_futures) {
+                layer_future.wait();
+            }
+            for (size_t layer_idx = 0; layer_idx < layer_count; ++layer_idx) {
+                layer_buffers[layer_idx] = layer_futures[layer_idx].get();
+            }
+        } else {
+            for (size_t layer_idx = 0; layer_idx < layer_count; ++layer_idx) {
+                layer_buffers[layer_idx] = render_layer(layer_idx);
+            }
+        }
+
+        size_t total_size = 0;
+        for (const auto &buffer : layer_buffers) {
+            total_size += buffer.size();
+        }
+        string result;
+        result.reserve(total_size);
+        for (const auto &buffer : layer_buffers) {
+            result += buffer;
+        }
+        return result;
+    }
+}
 
-    unordered_map<string, function<void(Svg::Document &)>> funcs{
-            {"bus_lines",   [this](Svg::Document &doc) { DrawBusLines(doc); }},
-            {"bus_labels",  [this](Svg::Document &doc) { DrawBusLabels(doc); }},
-            {"stop_points", [this](Svg::Document &doc) { DrawStopPoints(doc); }},
-            {"stop_labels", [this](Svg::Document &doc) { DrawStopLabels(doc); }},
+const unordered_map<string, MapRenderer::LayerDrawers> &MapRenderer::GetLayerDrawersByName() {
+    static const unordered_map<string, LayerDrawers> layer_drawers{
+            {"bus_lines",   {&MapRenderer::DrawBusLines,   &MapRenderer::DrawBusLinesInRoute}},
+            {"bus_labels",  {&MapRenderer::DrawBusLabels,  &MapRenderer::DrawBusLabelsInRoute}},
+            {"stop_points", {&MapRenderer::DrawStopPoints, &MapRenderer::DrawStopPointsInRoute}},
+            {"stop_labels", {&MapRenderer::DrawStopLabels, &MapRenderer::DrawStopLabelsInRoute}},
     };
+    return layer_drawers;
+}
 
+void MapRenderer::IndexStops() {
+    stop_ids_.clear();
+    stop_ids_.reserve(stops_for_render_.size());
+    for (const auto&[stop_name, coords] : stops_for_render_) {
+        stop_ids_.emplace(stop_name, stop_ids_.size());
+    }
+}
+
+void MapRenderer::CompileRenderPlan() {
+    render_plan_.clear();
+    render_plan_.reserve(render_settings.layers.size());
     for (const auto &layer_name : render_settings.layers) {
-        auto &render_func = funcs.at(layer_name);
-        render_func(doc);
+        render_plan_.push_back(GetLayerDrawersByName().at(layer_name));
     }
+    render_pool_ = render_plan_.size() > 1 ? make_unique<ThreadPool>(render_plan_.size()) : nullptr;
+}
+
+string MapRenderer::RenderMapLayers() const {
+    return RenderLayersToString(
+            render_plan_.size(),
+            [this](size_t layer_idx, Svg::Document &doc) { (this->*render_plan_[layer_idx].map_drawer)(doc); },
+            render_pool_.get(),
+            render_settings.svg_render_options
+    );
 }
 
 std::string MapRenderer::RenderMap() const {
     stringstream ss;
-    built_base_map_document.Render(ss);
+    Svg::Document::RenderHeader(ss, render_settings.svg_render_options);
+    ss << GetBaseMapObjects();
+    Svg::Document::RenderFooter(ss, render_settings.svg_render_options);
     return ss.str();
 }
 
@@ -493,35 +667,84 @@ void MapRenderer::RenderShadowingRectInplace(Svg::Document &doc) const {
     );
 }
 
-void MapRenderer::RenderRouteInplace(Svg::Document &doc, const std::vector<TransportRouter::RouteInfo::BusItem> &items) const {
-    if (items.empty()) { return; }
+string MapRenderer::RenderRouteLayers(const RouteBusItems &items) const {
+    if (items.empty()) { return ""; }
 
-    unordered_map<string, function<void(Svg::Document &, const std::vector<TransportRouter::RouteInfo::BusItem> &)>> funcs{
-            {"bus_lines",   [this](Svg::Document &doc, const std::vector<TransportRouter::RouteInfo::BusItem> &route_bus_items) { DrawBusLinesInRoute(doc, route_bus_items); }},
-            {"bus_labels",  [this](Svg::Document &doc, const std::vector<TransportRouter::RouteInfo::BusItem> &route_bus_items) { DrawBusLabelsInRoute(doc, route_bus_items); }},
-            {"stop_points", [this](Svg::Document &doc, const std::vector<TransportRouter::RouteInfo::BusItem> &route_bus_items) { DrawStopPointsInRoute(doc, route_bus_items); }},
-            {"stop_labels", [this](Svg::Document &doc, const std::vector<TransportRouter::RouteInfo::BusItem> &route_bus_items) { DrawStopLabelsInRoute(doc, route_bus_items); }},
-    };
+    size_t route_stop_count = 0;
+    for (const auto &bus_item : items) {
+        route_stop_count += bus_item.finish_stop_idx - bus_item.start_stop_idx + 1;
+    }
 
-    for (const auto &layer_name : render_settings.layers) {
-        auto &render_func = funcs.at(layer_name);
-        render_func(doc, items);
+    return RenderLayersToString(
+            render_plan_.size(),
+            [this, &items](size_t layer_idx, Svg::Document &doc) { (this->*render_plan_[layer_idx].route_drawer)(doc, items); },
+            route_stop_count >= PARALLEL_ROUTE_RENDER_MIN_STOPS ? render_pool_.get() : nullptr,
+            render_settings.svg_render_options
+    );
+}
+
+
+size_t MapRenderer::RouteRenderKeyHash::operator()(const RouteRenderKey &key) const {
+    size_t hash = key.size();
+    auto combine = [&hash](size_t value_hash) { hash ^= value_hash + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2); };
+    for (const auto&[bus_name, start_stop_idx, finish_stop_idx] : key) {
+        combine(std::hash<string>()(bus_name));
+        combine(start_stop_idx);
+        combine(finish_stop_idx);
     }
+    return hash;
 }
 
+shared_ptr<const string> MapRenderer::RenderRoute(const std::vector<TransportRouter::RouteInfo::BusItem> &items) const {
+    RouteRenderKey key;
+    key.reserve(items.size());
+    for (const auto &bus_item : items) {
+        key.emplace_back(bus_item.bus_name, bus_item.start_stop_idx, bus_item.finish_stop_idx);
+    }
 
-std::string MapRenderer::RenderRoute(const std::vector<TransportRouter::RouteInfo::BusItem> &items) const {
-    Svg::Document doc = built_base_map_document;
+    if (auto cached = route_render_cache_->Get(key)) {
+        return *cached;
+    }
+    auto rendered = make_shared<const string>(RenderRouteUncached(items));
+    route_render_cache_->Put(move(key), rendered);
+    return rendered;
+}
 
-    RenderShadowingRectInplace(doc);
+LruCacheStats MapRenderer::GetRouteRenderCacheStats() const {
+    return route_render_cache_->GetStats();
+}
 
-    RenderRouteInplace(doc, items);
+std::string MapRenderer::RenderRouteUncached(const RouteBusItems &items) const {
+    Svg::Document shadowing_rect_doc;
+    RenderShadowingRectInplace(shadowing_rect_doc);
 
     stringstream ss;
-    doc.Render(ss);
+    Svg::Document::RenderHeader(ss, render_settings.svg_render_options);
+    ss << GetBaseMapObjects();
+    shadowing_rect_doc.RenderObjects(ss, render_settings.svg_render_options);
+    ss << RenderRouteLayers(items);
+    Svg::Document::RenderFooter(ss, render_settings.svg_render_options);
     return ss.str();
 }
 
+RouteGeometry MapRenderer::BuildRouteGeometry(const std::vector<TransportRouter::RouteInfo::BusItem> &items) const {
+    RouteGeometry geometry;
+    geometry.segments.reserve(items.size());
+    for (const auto &bus_item : items) {
+        const auto &bus_desc = buses_for_render_.at(bus_item.bus_name);
+
+        RouteGeometry::BusSegment &segment = geometry.segments.emplace_back();
+        segment.bus_name = bus_item.bus_name;
+        segment.color_idx = bus_line_colors.at(bus_item.bus_name);
+        for (size_t i = bus_item.start_stop_idx; i <= bus_item.finish_stop_idx; i++) {
+            const string &stop_name = bus_desc.stops.at(i);
+            segment.stop_ids.push_back(stop_ids_.at(stop_name));
+            segment.points.push_back(converter(stops_for_render_.at(stop_name)));
+        }
+    }
+    return geometry;
+}
+
 Serialization::MapRenderer MapRenderer::SerializeMapRenderer() const {
     Serialization::MapRenderer serialization_renderer;
 
@@ -557,12 +780,9 @@ Serialization::MapRenderer MapRenderer::SerializeMapRenderer() const {
     return serialization_renderer;
 }
 
-Svg::Document MapRenderer::BuildBaseMap() const {
-    Svg::Document doc;
-
-    RenderMapInplace(doc);
-
-    return doc;
+const std::string &MapRenderer::GetBaseMapObjects() const {
+    call_once(*base_map_once_, [this] { built_base_map_objects_ = RenderMapLayers(); });
+    return built_base_map_objects_;
 }
 
 void MapRenderer::DrawBusLines(Svg::Document &doc) const {
@@ -4,8 +4,10 @@
 
 #include "descriptions.h"
 #include "json.h"
+#include "lru_cache.h"
 #include "sphere.h"
 #include "svg.h"
+#include "thread_pool.h"
 #include "transport_router.h"
 
 struct RenderSettings {
@@ -34,6 +36,10 @@ struct RenderSettings {
             layers.push_back(serialization_render_settings.layers(layers_idx));
         }
         outer_margin = serialization_render_settings.outer_margin();
+        if (serialization_render_settings.has_svg_precision()) {
+            svg_render_options.precision = serialization_render_settings.svg_precision();
+        }
+        svg_render_options.minified = serialization_render_settings.svg_minified();
     }
 
     Serialization::RenderSettings SerializeRenderSettings() const {
@@ -70,6 +76,10 @@ struct RenderSettings {
             serialization_render_settings.add_layers(cur_layer);
         }
         serialization_render_settings.set_outer_margin(outer_margin);
+        if (svg_render_options.precision.has_value()) {
+            serialization_render_settings.set_svg_precision(*svg_render_options.precision);
+        }
+        serialization_render_settings.set_svg_minified(svg_render_options.minified);
 
         return serialization_render_settings;
     }
@@ -88,6 +98,7 @@ struct RenderSettings {
     Svg::Point bus_label_offset;
     std::vector<std::string> layers;
     double outer_margin;
+    Svg::RenderOptions svg_render_options;
 };
 
 struct BusDescForRender {
@@ -95,6 +106,18 @@ struct BusDescForRender {
     bool is_roundtrip;
 };
 
+// Route drawn as screen-space polylines, without any SVG
+struct RouteGeometry {
+    struct BusSegment {
+        std::string bus_name;
+        int color_idx;  // in render_settings.color_palette
+        std::vector<size_t> stop_ids;  // index of stop among all stops ordered by name
+        std::vector<Svg::Point> points;  // parallel to stop_ids
+    };
+
+    std::vector<BusSegment> segments;
+};
+
 class PointConverter {
 public:
     PointConverter();
@@ -163,7 +186,8 @@ private:
     double x_step;
     double y_step;
 
-    std::unordered_map<Sphere::Point, int, Sphere::PointHash> x_stop_coord_idx, y_stop_coord_idx;
+    std::vector<Sphere::Point> sorted_points;  // distinct stop coords, ordered by Sphere::PointLess
+    std::vector<int> x_coord_idx, y_coord_idx;  // compressed indices, parallel to sorted_points
 };
 
 class PointConverterIntermediateStops {
@@ -179,7 +203,8 @@ public:
     Serialization::PointConverterIntermediateStops SerializeConverter() const;
 
 private:
-    std::unordered_map<Sphere::Point, Sphere::Point, Sphere::PointHash> mapping;
+    std::vector<Sphere::Point> points_from;  // ordered by Sphere::PointLess
+    std::vector<Sphere::Point> points_to;  // parallel to points_from
 };
 
 class PointConverterIntermFlattenCompr {
@@ -209,18 +234,52 @@ public:
 
     std::string RenderMap() const;
 
-    std::string RenderRoute(const std::vector<TransportRouter::RouteInfo::BusItem> &items) const;
+    // Shared with the route render cache
+    std::shared_ptr<const std::string> RenderRoute(const std::vector<TransportRouter::RouteInfo::BusItem> &items) const;
+
+    RouteGeometry BuildRouteGeometry(const std::vector<TransportRouter::RouteInfo::BusItem> &items) const;
+
+    LruCacheStats GetRouteRenderCacheStats() const;
 
     Serialization::MapRenderer SerializeMapRenderer() const;
 
 private:
-    Svg::Document BuildBaseMap() const;
+    using RouteBusItems = std::vector<TransportRouter::RouteInfo::BusItem>;
+    using MapLayerDrawer = void (MapRenderer::*)(Svg::Document &) const;
+    using RouteLayerDrawer = void (MapRenderer::*)(Svg::Document &, const RouteBusItems &) const;
+
+    struct LayerDrawers {
+        MapLayerDrawer map_drawer;
+        RouteLayerDrawer route_drawer;
+    };
+
+    static const std::unordered_map<std::string, LayerDrawers> &GetLayerDrawersByName();
+
+    void IndexStops();
 
-    void RenderMapInplace(Svg::Document &doc) const;
+    void CompileRenderPlan();
+
+    // Rendered on the first map or route render, not at load
+    const std::string &GetBaseMapObjects() const;
+
+    std::string RenderMapLayers() const;
 
     void RenderShadowingRectInplace(Svg::Document &doc) const;
 
-    void RenderRouteInplace(Svg::Document &doc, const std::vector<TransportRouter::RouteInfo::BusItem> &route_bus_items) const;
+    std::string RenderRouteLayers(const RouteBusItems &route_bus_items) const;
+
+    std::string RenderRouteUncached(const RouteBusItems &route_bus_items) const;
+
+    // Rendered route map depends only on (bus_name, start_stop_idx, finish_stop_idx) of its bus items
+    using RouteRenderKey = std::vector<std::tuple<std::string, size_t, size_t>>;
+
+    struct RouteRenderKeyHash {
+        size_t operator()(const RouteRenderKey &key) const;
+    };
+
+    using RouteRenderCache = LruCache<RouteRenderKey, std::shared_ptr<const std::string>, RouteRenderKeyHash>;
+
+    static constexpr size_t ROUTE_RENDER_CACHE_CAPACITY = 256;
 
     template<typename It>
     Svg::Polyline DrawPolylineFromStops(It it_begin, It it_end, int color_idx) const {
@@ -266,6 +325,13 @@ private:
     RenderSettings render_settings;
     PointConverterIntermFlattenCompr converter;
     std::unordered_map<std::string, int> bus_line_colors;
+    std::unordered_map<std::string, size_t> stop_ids_;  // index in stops_for_render_
+
+    std::vector<LayerDrawers> render_plan_;  // render_settings.layers resolved once, in layer order
+    std::unique_ptr<ThreadPool> render_pool_;  // one worker per layer, none for a single layer
+
+    std::unique_ptr<std::once_flag> base_map_once_ = std::make_unique<std::once_flag>();
+    mutable std::string built_base_map_objects_;  // rendered svg objects of the base map, without header and footer
 
-    Svg::Document built_base_map_document;
+    std::unique_ptr<RouteRenderCache> route_render_cache_ = std::make_unique<RouteRenderCache>(ROUTE_RENDER_CACHE_CAPACITY);
 };
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <list>
+
+#include "descriptions.h"
+#include "json.h"
+#include "map_renderer.h"
+
+using namespace std;
+
+// Usage: map_renderer_benchmark [grid_size]
+// Renders a grid city of grid_size x grid_size stops with a bus along every row and column,
+// and prints response bytes and rendering time of the map and of distinct routes for several svg render settings.
+
+namespace {
+    struct City {
+        list<Descriptions::Stop> stops;
+        list<Descriptions::Bus> buses;
+        Descriptions::StopsDict stops_dict;
+        Descriptions::BusesDict buses_dict;
+    };
+
+    string GridStopName(int row, int col) {
+        return "Stop " + to_string(row) + "_" + to_string(col);
+    }
+
+    City MakeGridCity(int grid_size) {
+        City city;
+        for (int row = 0; row < grid_size; ++row) {
+            for (int col = 0; col < grid_size; ++col) {
+                auto &stop = city.stops.emplace_back();
+                stop.name = GridStopName(row, col);
+                stop.position = {55.5 + row * 0.01 + (col % 3) * 0.002, 37.5 + col * 0.01 + (row % 2) * 0.003};
+                city.stops_dict[stop.name] = &stop;
+            }
+        }
+        for (int line = 0; line < grid_size; ++line) {
+            auto &row_bus = city.buses.emplace_back();
+            row_bus.name = "R" + to_string(line);
+            row_bus.is_roundtrip = false;
+            auto &col_bus = city.buses.emplace_back();
+            col_bus.name = "C" + to_string(line);
+            col_bus.is_roundtrip = false;
+            for (int pos = 0; pos < grid_size; ++pos) {
+                row_bus.stops.push_back(GridStopName(line, pos));
+                col_bus.stops.push_back(GridStopName(pos, line));
+            }
+            for (int pos = grid_size - 2; pos >= 0; --pos) {  // as Descriptions::ParseStops does for non-roundtrip buses
+                row_bus.stops.push_back(GridStopName(line, pos));
+                col_bus.stops.push_back(GridStopName(pos, line));
+            }
+            city.buses_dict[row_bus.name] = &row_bus;
+            city.buses_dict[col_bus.name] = &col_bus;
+        }
+        return city;
+    }
+
+    Json::Dict MakeRenderSettingsJson(optional<int> svg_precision, bool svg_minified) {
+        Json::Dict render_settings{
+                {"width",                Json::Node(1200.0)},
+                {"height",               Json::Node(800.0)},
+                {"padding",              Json::Node(50.0)},
+                {"stop_radius",          Json::Node(5.0)},
+                {"line_width",           Json::Node(14.0)},
+                {"stop_label_font_size", Json::Node(18)},
+                {"stop_label_offset",    Json::Node(vector<Json::Node>{Json::Node(7.0), Json::Node(-3.0)})},
+                {"underlayer_color",     Json::Node(vector<Json::Node>{Json::Node(255), Json::Node(255), Json::Node(255), Json::Node(0.85)})},
+                {"underlayer_width",     Json::Node(3.0)},
+                {"color_palette",        Json::Node(vector<Json::Node>{Json::Node("green"s), Json::Node("red"s),
+                                                                       Json::Node(vector<Json::Node>{Json::Node(255), Json::Node(160), Json::Node(0)})})},
+                {"bus_label_font_size",  Json::Node(20)},
+                {"bus_label_offset",     Json::Node(vector<Json::Node>{Json::Node(7.0), Json::Node(15.0)})},
+                {"layers",               Json::Node(vector<Json::Node>{Json::Node("bus_lines"s), Json::Node("bus_labels"s),
+                                                                       Json::Node("stop_points"s), Json::Node("stop_labels"s)})},
+                {"outer_margin",         Json::Node(150.0)},
+                {"svg_minified",         Json::Node(svg_minified)},
+        };
+        if (svg_precision) {
+            render_settings["svg_precision"] = Json::Node(*svg_precision);
+        }
+        return render_settings;
+    }
+
+    // Distinct routes, so that none of them is served by the route render cache
+    vector<vector<TransportRouter::RouteInfo::BusItem>> MakeRoutes(int grid_size) {
+        vector<vector<TransportRouter::RouteInfo::BusItem>> routes;
+        for (int line = 0; line + 1 < grid_size; ++line) {
+            const size_t span = grid_size - 1;
+            routes.push_back({
+                    {"R" + to_string(line), 0.0, span, 0, span},
+                    {"C" + to_string(grid_size - 1), 0.0, span - line, static_cast<size_t>(line), span},
+            });
+        }
+        return routes;
+    }
+
+    double MillisecondsSince(chrono::steady_clock::time_point start) {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, const char *argv[]) {
+    const int grid_size = argc > 1 ? stoi(argv[1]) : 30;
+    const City city = MakeGridCity(grid_size);
+    const auto routes = MakeRoutes(grid_size);
+
+    struct Mode {
+        string name;
+        optional<int> svg_precision;
+        bool svg_minified;
+    };
+    const vector<Mode> modes{
+            {"default",                 nullopt, false},
+            {"precision 1",             1,       false},
+            {"minified",                nullopt, true},
+            {"minified, precision 1",   1,       true},
+            {"minified, precision 0",   0,       true},
+    };
+
+    cout << "grid " << grid_size << "x" << grid_size << ", " << routes.size() << " routes" << endl;
+    cout << left << setw(24) << "mode" << right << setw(12) << "base ms" << setw(12) << "map bytes"
+         << setw(14) << "routes ms" << setw(16) << "bytes/route" << endl;
+    for (const auto &mode : modes) {
+        auto start = chrono::steady_clock::now();
+        const MapRenderer renderer(city.stops_dict, city.buses_dict, MakeRenderSettingsJson(mode.svg_precision, mode.svg_minified));
+        const size_t map_bytes = renderer.RenderMap().size();  // the base map is rendered on the first call
+        const double base_ms = MillisecondsSince(start);
+
+        start = chrono::steady_clock::now();
+        size_t route_bytes = 0;
+        for (const auto &route : routes) {
+            route_bytes += renderer.RenderRoute(route)->size();
+        }
+        const double routes_ms = MillisecondsSince(start);
+
+        cout << left << setw(24) << mode.name << right << fixed << setprecision(2)
+             << setw(12) << base_ms << setw(12) << map_bytes
+             << setw(14) << routes_ms << setw(16) << route_bytes / max<size_t>(routes.size(), 1) << endl;
+    }
+
+    return 0;
+}
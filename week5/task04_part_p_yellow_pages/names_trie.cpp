@@ -0,0 +1,198 @@
+#include "names_trie.h"
+
+#include <algorithm>
+#include <queue>
+#include <tuple>
+
+using namespace std;
+
+
+namespace {
+    size_t GetUtf8SequenceLength(unsigned char lead_byte) {
+        if ((lead_byte & 0xE0u) == 0xC0u) { return 2; }
+        if ((lead_byte & 0xF0u) == 0xE0u) { return 3; }
+        if ((lead_byte & 0xF8u) == 0xF0u) { return 4; }
+        return 1;  // ASCII, or a broken sequence taken byte by byte
+    }
+
+    // Names are compared by code points, that are kept as their UTF-8 bytes
+    vector<string_view> SplitToCodePoints(string_view str) {
+        vector<string_view> code_points;
+        while (!str.empty()) {
+            const size_t length = min(GetUtf8SequenceLength(str.front()), str.size());
+            code_points.push_back(str.substr(0, length));
+            str.remove_prefix(length);
+        }
+        return code_points;
+    }
+}
+
+NamesTrie::NamesTrie() : children_begin_{1, 1}, labels_(1, '\0'), node_names_{NO_NAME}, items_begin_{0} {}
+
+NamesTrie::NamesTrie(vector<pair<string, ItemId>> named_items) : NamesTrie() {
+    sort(named_items.begin(), named_items.end());
+    named_items.erase(unique(named_items.begin(), named_items.end()), named_items.end());
+
+    for (auto &[name, item_id] : named_items) {
+        if (names_.empty() || names_.back() != name) {
+            items_begin_.push_back(items_.size());
+            names_.push_back(move(name));
+        }
+        items_.push_back(item_id);
+        items_begin_.back() = items_.size();
+    }
+
+    // Every node covers the consecutive range of the sorted names starting with its path
+    struct NodeRange {
+        size_t names_begin;
+        size_t names_end;
+        size_t depth;
+    };
+    children_begin_.clear();
+    queue<NodeRange> nodes_queue;
+    nodes_queue.push({0, names_.size(), 0});
+    for (NodeId node = 0; !nodes_queue.empty(); ++node) {
+        auto [names_begin, names_end, depth] = nodes_queue.front();
+        nodes_queue.pop();
+
+        children_begin_.push_back(labels_.size());
+        if (names_begin < names_end && names_[names_begin].size() == depth) {  // a prefix is sorted before its continuations
+            node_names_[node] = names_begin + 1;
+            ++names_begin;
+        }
+        while (names_begin < names_end) {
+            const char label = names_[names_begin][depth];
+            size_t child_names_end = names_begin;
+            while (child_names_end < names_end && names_[child_names_end][depth] == label) {
+                ++child_names_end;
+            }
+            labels_.push_back(label);
+            node_names_.push_back(NO_NAME);
+            nodes_queue.push({names_begin, child_names_end, depth + 1});
+            names_begin = child_names_end;
+        }
+    }
+    children_begin_.push_back(labels_.size());
+}
+
+NamesTrie::NamesTrie(const Serialization::NamesTrie &serialization_names_trie)
+        : children_begin_(serialization_names_trie.children_begin().begin(), serialization_names_trie.children_begin().end()),
+          labels_(serialization_names_trie.labels()),
+          node_names_(serialization_names_trie.node_names().begin(), serialization_names_trie.node_names().end()),
+          names_(serialization_names_trie.names().begin(), serialization_names_trie.names().end()),
+          items_begin_(serialization_names_trie.items_begin().begin(), serialization_names_trie.items_begin().end()),
+          items_(serialization_names_trie.items().begin(), serialization_names_trie.items().end()) {}
+
+pair<NamesTrie::NodeId, NamesTrie::NodeId> NamesTrie::GetChildren(NodeId node) const {
+    return {children_begin_[node], children_begin_[node + 1]};
+}
+
+vector<NamesTrie::FoundName> NamesTrie::FindByPrefix(string_view prefix, size_t limit) const {
+    NodeId node = 0;
+    for (const char byte : prefix) {
+        const auto [children_begin, children_end] = GetChildren(node);
+        const auto labels_begin = labels_.begin() + children_begin, labels_end = labels_.begin() + children_end;
+        const auto label_it = lower_bound(labels_begin, labels_end, byte, [](char lhs, char rhs) {
+            return static_cast<unsigned char>(lhs) < static_cast<unsigned char>(rhs);
+        });
+        if (label_it == labels_end || *label_it != byte) {
+            return {};
+        }
+        node = label_it - labels_.begin();
+    }
+
+    // Depth-first with the children in label order gives the names in lexicographical order
+    vector<FoundName> found_names;
+    vector<NodeId> nodes_stack{node};
+    while (!nodes_stack.empty() && found_names.size() < limit) {
+        const NodeId cur_node = nodes_stack.back();
+        nodes_stack.pop_back();
+        if (node_names_[cur_node] != NO_NAME) {
+            found_names.push_back({node_names_[cur_node] - 1, 0});
+        }
+        const auto [children_begin, children_end] = GetChildren(cur_node);
+        for (NodeId child = children_end; child > children_begin; --child) {
+            nodes_stack.push_back(child - 1);
+        }
+    }
+    return found_names;
+}
+
+vector<NamesTrie::FoundName> NamesTrie::FindSimilar(string_view name, size_t max_edits, size_t limit) const {
+    const vector<string_view> name_code_points = SplitToCodePoints(name);
+
+    // Levenshtein distances from the path of the node to every prefix of the name, updated once per whole code point of the path
+    struct SearchState {
+        NodeId node;
+        vector<size_t> distances;
+        string pending_code_point;  // bytes of the path after the last whole code point
+    };
+    vector<SearchState> states_stack;
+    vector<size_t> first_distances(name_code_points.size() + 1);
+    for (size_t prefix_length = 0; prefix_length <= name_code_points.size(); ++prefix_length) {
+        first_distances[prefix_length] = prefix_length;
+    }
+    states_stack.push_back({0, move(first_distances), ""});
+
+    vector<FoundName> found_names;
+    while (!states_stack.empty()) {
+        SearchState state = move(states_stack.back());
+        states_stack.pop_back();
+
+        if (state.pending_code_point.empty() && node_names_[state.node] != NO_NAME && state.distances.back() <= max_edits) {
+            found_names.push_back({node_names_[state.node] - 1, state.distances.back()});
+        }
+
+        const auto [children_begin, children_end] = GetChildren(state.node);
+        for (NodeId child = children_begin; child < children_end; ++child) {
+            SearchState child_state{child, {}, state.pending_code_point + labels_[child]};
+            if (child_state.pending_code_point.size() < GetUtf8SequenceLength(child_state.pending_code_point.front())) {
+                child_state.distances = state.distances;
+                states_stack.push_back(move(child_state));
+                continue;
+            }
+
+            child_state.distances.resize(state.distances.size());
+            child_state.distances[0] = state.distances[0] + 1;
+            for (size_t prefix_length = 1; prefix_length <= name_code_points.size(); ++prefix_length) {
+                child_state.distances[prefix_length] = min({
+                        state.distances[prefix_length] + 1,
+                        child_state.distances[prefix_length - 1] + 1,
+                        state.distances[prefix_length - 1] + (name_code_points[prefix_length - 1] == child_state.pending_code_point ? 0 : 1),
+                });
+            }
+            if (*min_element(child_state.distances.begin(), child_state.distances.end()) > max_edits) {
+                continue;
+            }
+            child_state.pending_code_point.clear();
+            states_stack.push_back(move(child_state));
+        }
+    }
+
+    sort(found_names.begin(), found_names.end(), [](const FoundName &lhs, const FoundName &rhs) {
+        return tie(lhs.distance, lhs.name_idx) < tie(rhs.distance, rhs.name_idx);
+    });
+    if (found_names.size() > limit) {
+        found_names.resize(limit);
+    }
+    return found_names;
+}
+
+const string &NamesTrie::GetName(size_t name_idx) const {
+    return names_[name_idx];
+}
+
+vector<NamesTrie::ItemId> NamesTrie::GetItems(size_t name_idx) const {
+    return {items_.begin() + items_begin_[name_idx], items_.begin() + items_begin_[name_idx + 1]};
+}
+
+Serialization::NamesTrie NamesTrie::SerializeNamesTrie() const {
+    Serialization::NamesTrie serialization_names_trie;
+    *serialization_names_trie.mutable_children_begin() = {children_begin_.begin(), children_begin_.end()};
+    serialization_names_trie.set_labels(labels_);
+    *serialization_names_trie.mutable_node_names() = {node_names_.begin(), node_names_.end()};
+    *serialization_names_trie.mutable_names() = {names_.begin(), names_.end()};
+    *serialization_names_trie.mutable_items_begin() = {items_begin_.begin(), items_begin_.end()};
+    *serialization_names_trie.mutable_items() = {items_.begin(), items_.end()};
+    return serialization_names_trie;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "transport_catalog.pb.h"
+
+
+// Static trie of names with the ids of the items under each name, for prefix and bounded edit distance queries.
+// Nodes are in breadth-first order, so the children of a node are consecutive and the trie is a few flat arrays.
+class NamesTrie {
+public:
+    using ItemId = uint32_t;
+
+    struct FoundName {
+        size_t name_idx;
+        size_t distance;  // edits from the query, in code points
+    };
+
+    NamesTrie();
+
+    explicit NamesTrie(std::vector<std::pair<std::string, ItemId>> named_items);
+
+    explicit NamesTrie(const Serialization::NamesTrie &serialization_names_trie);
+
+    // In lexicographical order, at most limit of them
+    std::vector<FoundName> FindByPrefix(std::string_view prefix, size_t limit) const;
+
+    // Nearest first, then in lexicographical order, at most limit of them
+    std::vector<FoundName> FindSimilar(std::string_view name, size_t max_edits, size_t limit) const;
+
+    const std::string &GetName(size_t name_idx) const;
+
+    // Sorted, without duplicates
+    std::vector<ItemId> GetItems(size_t name_idx) const;
+
+    Serialization::NamesTrie SerializeNamesTrie() const;
+
+private:
+    using NodeId = uint32_t;
+
+    static constexpr uint32_t NO_NAME = 0;  // in node_names_, where names are numbered from 1
+
+    std::pair<NodeId, NodeId> GetChildren(NodeId node) const;
+
+    std::vector<NodeId> children_begin_;  // children of node v are [children_begin_[v], children_begin_[v + 1])
+    std::string labels_;  // byte on the edge to the node, sorted among siblings
+    std::vector<uint32_t> node_names_;
+
+    std::vector<std::string> names_;  // sorted
+    std::vector<uint32_t> items_begin_;  // items of name i are [items_begin_[i], items_begin_[i + 1])
+    std::vector<ItemId> items_;
+};
@@ -1,8 +1,12 @@
 #include "requests.h"
 
+#include <cmath>
+#include <stdexcept>
+
 using namespace std;
 
 namespace Requests {
+    const size_t SUGGEST_COMPANY_NAMES_DEFAULT_LIMIT = 10;
 
     Json::Dict Stop::Process(const TransportCatalog &db) const {
         const auto *stop = db.GetStop(name);
@@ -55,6 +59,47 @@ namespace Requests {
         }
     };
 
+    // Google encoded polyline format over integer screen coords: x0, y0, then deltas from the previous point
+    string EncodePolyline(const vector<Svg::Point> &points) {
+        string encoded;
+        auto encode_value = [&encoded](long value) {
+            unsigned long chunks = value < 0 ? ~(static_cast<unsigned long>(value) << 1) : static_cast<unsigned long>(value) << 1;
+            while (chunks >= 0x20) {
+                encoded.push_back(static_cast<char>((0x20 | (chunks & 0x1f)) + 63));
+                chunks >>= 5;
+            }
+            encoded.push_back(static_cast<char>(chunks + 63));
+        };
+
+        long prev_x = 0, prev_y = 0;
+        for (const Svg::Point p : points) {
+            const long x = lround(p.x), y = lround(p.y);
+            encode_value(x - prev_x);
+            encode_value(y - prev_y);
+            prev_x = x, prev_y = y;
+        }
+        return encoded;
+    }
+
+    Json::Node BuildRoutePolylinesResponse(const RouteGeometry &geometry) {
+        vector<Json::Node> segments;
+        segments.reserve(geometry.segments.size());
+        for (const auto &segment : geometry.segments) {
+            vector<Json::Node> stop_ids;
+            stop_ids.reserve(segment.stop_ids.size());
+            for (const size_t stop_id : segment.stop_ids) {
+                stop_ids.emplace_back(static_cast<int>(stop_id));
+            }
+            segments.emplace_back(Json::Dict{
+                    {"bus",       Json::Node(segment.bus_name)},
+                    {"color_idx", Json::Node(segment.color_idx)},
+                    {"stop_ids",  Json::Node(move(stop_ids))},
+                    {"points",    Json::Node(EncodePolyline(segment.points))},
+            });
+        }
+        return Json::Node(move(segments));
+    }
+
     Json::Dict Route::Process(const TransportCatalog &db) const {
         Json::Dict dict;
         const auto route = db.FindRoute(stop_from, stop_to);
@@ -77,20 +122,161 @@ namespace Requests {
                     bus_items.push_back(get<TransportRouter::RouteInfo::BusItem>(item));
                 }
             }
-            dict["map"] = Json::Node(db.RenderRoute(bus_items));
+            if (map_format == MapFormat::POLYLINE) {
+                dict["map_polylines"] = BuildRoutePolylinesResponse(db.BuildRouteGeometry(bus_items));
+            } else {
+                dict["map"] = Json::Node(*db.RenderRoute(bus_items));
+            }
         }
 
         return dict;
     }
 
+    Json::Node BuildSearchPlanResponse(const YellowPagesSearch::SearchPlan &plan) {
+        vector<Json::Node> skipped;
+        skipped.reserve(plan.skipped_constraint_names.size());
+        for (const auto &constraint_name : plan.skipped_constraint_names) {
+            skipped.emplace_back(constraint_name);
+        }
+
+        vector<Json::Node> steps;
+        steps.reserve(plan.steps.size());
+        for (const auto &step : plan.steps) {
+            steps.emplace_back(Json::Dict{
+                    {"constraint",       Json::Node(step.constraint_name)},
+                    {"method",           Json::Node(YellowPagesSearch::ToString(step.method))},
+                    {"estimated_count",  Json::Node(static_cast<int>(step.estimated_count))},
+                    {"candidates_count", Json::Node(static_cast<int>(step.candidates_count))},
+            });
+        }
+
+        return Json::Dict{
+                {"skipped", Json::Node(move(skipped))},
+                {"steps",   Json::Node(move(steps))},
+        };
+    }
+
+    vector<const YellowPagesDatabase::Company *> FindCompanies::Search(const TransportCatalog &db, YellowPagesSearch::SearchPlan *plan) const {
+        return db.SearchCompanies({&names_constraint_, &phones_constraint_, &urls_constraint_, &rubrics_constraint_, &working_time_constraint_}, plan);
+    }
+
     Json::Dict FindCompanies::Process(const TransportCatalog &db) const {
+        YellowPagesSearch::SearchPlan plan;
         vector<Json::Node> company_names_array;
-        for (const auto found_company_ptr : db.SearchCompanies({&names_constraint_, &phones_constraint_, &urls_constraint_, &rubrics_constraint_})) {
-            company_names_array.emplace_back(found_company_ptr->get_main_name());
+        for (const auto found_company_ptr : Search(db, explain_ ? &plan : nullptr)) {
+            company_names_array.emplace_back(string(found_company_ptr->get_main_name()));
         }
-        return {
+
+        Json::Dict dict{
                 {"companies", move(company_names_array)}
         };
+        if (explain_) {
+            dict["plan"] = BuildSearchPlanResponse(plan);
+        }
+        return dict;
+    }
+
+    Json::Dict RouteToCompany::Process(const TransportCatalog &db) const {
+        Json::Dict dict;
+        const auto company_route = db.FindRouteToCompany(stop_from, companies.Search(db));
+        if (!company_route) {
+            dict["error_message"] = Json::Node("not found"s);
+        } else {
+            dict["total_time"] = Json::Node(company_route->route.total_time + company_route->walk_time);
+
+            vector<Json::Node> items;
+            items.reserve(company_route->route.items.size() + 1);
+            for (const auto &item : company_route->route.items) {
+                items.emplace_back(visit(RouteItemResponseBuilder{}, item));
+            }
+            items.emplace_back(Json::Dict{
+                    {"type",      Json::Node("WalkToCompany"s)},
+                    {"time",      Json::Node(company_route->walk_time)},
+                    {"stop_name", Json::Node(company_route->stop_name)},
+                    {"company",   Json::Node(string(company_route->company->get_main_name()))},
+            });
+            dict["items"] = move(items);
+        }
+        return dict;
+    }
+
+    Json::Dict StopsNear::Process(const TransportCatalog &db) const {
+        vector<Json::Node> stops;
+        for (const auto &stop_near : db.FindStopsNear(point, count, radius)) {
+            stops.emplace_back(Json::Dict{
+                    {"name",     Json::Node(stop_near.name)},
+                    {"distance", Json::Node(stop_near.distance)},
+            });
+        }
+        return {
+                {"stops", move(stops)}
+        };
+    }
+
+    Json::Dict CompaniesNear::Process(const TransportCatalog &db) const {
+        vector<Json::Node> companies;
+        for (const auto &company_near : db.FindCompaniesNear(point, count, radius)) {
+            companies.emplace_back(Json::Dict{
+                    {"company",  Json::Node(string(company_near.company->get_main_name()))},
+                    {"distance", Json::Node(company_near.distance)},
+            });
+        }
+        return {
+                {"companies", move(companies)}
+        };
+    }
+
+    Json::Dict SuggestCompanyNames::Process(const TransportCatalog &db) const {
+        const auto matches = max_edits ? db.FindSimilarCompanyNames(query, *max_edits, limit) : db.FindCompanyNamesByPrefix(query, limit);
+        vector<Json::Node> names;
+        for (const auto &match : matches) {
+            vector<Json::Node> companies;
+            for (const auto *company : match.companies) {
+                companies.emplace_back(string(company->get_main_name()));
+            }
+            names.emplace_back(Json::Dict{
+                    {"name",      Json::Node(match.name)},
+                    {"distance",  Json::Node(static_cast<int>(match.distance))},
+                    {"companies", Json::Node(move(companies))},
+            });
+        }
+        return {
+                {"names", move(names)}
+        };
+    }
+
+    Route::MapFormat ReadRouteMapFormat(const Json::Dict &attrs) {
+        if (!attrs.count("map_format")) {
+            return Route::MapFormat::SVG;
+        }
+        const string &map_format = attrs.at("map_format").AsString();
+        if (map_format == "svg") {
+            return Route::MapFormat::SVG;
+        } else if (map_format == "polyline") {
+            return Route::MapFormat::POLYLINE;
+        }
+        throw invalid_argument("Requests::ReadRouteMapFormat: unknown map_format \"" + map_format + "\", expected \"svg\" or \"polyline\"");
+    }
+
+    template<typename NearRequest>
+    NearRequest ReadNearRequest(const Json::Dict &attrs) {
+        return NearRequest{
+                {attrs.at("latitude").AsDouble(), attrs.at("longitude").AsDouble()},
+                attrs.count("count") ? optional<size_t>(attrs.at("count").AsInt()) : nullopt,
+                attrs.count("radius") ? optional<double>(attrs.at("radius").AsDouble()) : nullopt,
+        };
+    }
+
+    FindCompanies ReadFindCompanies(const Json::Dict &attrs, const std::unordered_map<std::string, uint64_t> &rubric_ids_dict) {
+        return FindCompanies(
+                attrs.count("names") ? attrs.at("names").AsArray() : vector<Json::Node>(),
+                attrs.count("phones") ? attrs.at("phones").AsArray() : vector<Json::Node>(),
+                attrs.count("urls") ? attrs.at("urls").AsArray() : vector<Json::Node>(),
+                attrs.count("rubrics") ? attrs.at("rubrics").AsArray() : vector<Json::Node>(),
+                attrs.count("datetime") ? attrs.at("datetime").AsArray() : vector<Json::Node>(),
+                rubric_ids_dict,
+                attrs.count("explain") && attrs.at("explain").AsBool()
+        );
     }
 
     Json::Dict Map::Process(const TransportCatalog &db) const {
@@ -99,22 +285,52 @@ namespace Requests {
         return dict;
     }
 
-    variant<Stop, Bus, Route, FindCompanies, Map> Read(const Json::Dict &attrs, const std::unordered_map<std::string, uint64_t> &rubric_ids_dict) {
+    Json::Node BuildCacheStatsResponse(const LruCacheStats &stats) {
+        return Json::Dict{
+                {"hits",      Json::Node(static_cast<int>(stats.hits))},
+                {"misses",    Json::Node(static_cast<int>(stats.misses))},
+                {"evictions", Json::Node(static_cast<int>(stats.evictions))},
+        };
+    }
+
+    Json::Dict CacheStats::Process(const TransportCatalog &db) const {
+        Json::Dict dict;
+        dict["route_render_cache"] = BuildCacheStatsResponse(db.GetRouteRenderCacheStats());
+        dict["companies_search_cache"] = BuildCacheStatsResponse(db.GetCompaniesSearchCacheStats());
+        return dict;
+    }
+
+    variant<Stop, Bus, Route, FindCompanies, RouteToCompany, StopsNear, CompaniesNear, SuggestCompanyNames, Map, CacheStats> Read(const Json::Dict &attrs, const std::unordered_map<std::string, uint64_t> &rubric_ids_dict) {
         const string &type = attrs.at("type").AsString();
         if (type == "Bus") {
             return Bus{attrs.at("name").AsString()};
         } else if (type == "Stop") {
             return Stop{attrs.at("name").AsString()};
         } else if (type == "Route") {
-            return Route{attrs.at("from").AsString(), attrs.at("to").AsString()};
+            return Route{
+                    attrs.at("from").AsString(),
+                    attrs.at("to").AsString(),
+                    ReadRouteMapFormat(attrs)
+            };
         } else if (type == "FindCompanies") {
-            return FindCompanies(
-                    attrs.count("names") ? attrs.at("names").AsArray() : vector<Json::Node>(),
-                    attrs.count("phones") ? attrs.at("phones").AsArray() : vector<Json::Node>(),
-                    attrs.count("urls") ? attrs.at("urls").AsArray() : vector<Json::Node>(),
-                    attrs.count("rubrics") ? attrs.at("rubrics").AsArray() : vector<Json::Node>(),
-                    rubric_ids_dict
-            );
+            return ReadFindCompanies(attrs, rubric_ids_dict);
+        } else if (type == "RouteToCompany") {
+            return RouteToCompany{
+                    attrs.at("from").AsString(),
+                    ReadFindCompanies(attrs.at("companies").AsMap(), rubric_ids_dict)
+            };
+        } else if (type == "StopsNear") {
+            return ReadNearRequest<StopsNear>(attrs);
+        } else if (type == "CompaniesNear") {
+            return ReadNearRequest<CompaniesNear>(attrs);
+        } else if (type == "SuggestCompanyNames") {
+            return SuggestCompanyNames{
+                    attrs.at("query").AsString(),
+                    attrs.count("max_edits") ? optional<size_t>(attrs.at("max_edits").AsInt()) : nullopt,
+                    attrs.count("limit") ? static_cast<size_t>(attrs.at("limit").AsInt()) : SUGGEST_COMPANY_NAMES_DEFAULT_LIMIT
+            };
+        } else if (type == "CacheStats") {
+            return CacheStats{};
         } else {
             return Map{};
         }
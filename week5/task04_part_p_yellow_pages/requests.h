@@ -20,8 +20,15 @@ namespace Requests {
     };
 
     struct Route {
+        // SVG: whole map in "map"; POLYLINE: only route geometry in "map_polylines", see EncodePolyline
+        enum class MapFormat {
+            SVG,
+            POLYLINE,
+        };
+
         std::string stop_from;
         std::string stop_to;
+        MapFormat map_format = MapFormat::SVG;
 
         Json::Dict Process(const TransportCatalog &db) const;
     };
@@ -31,10 +38,16 @@ namespace Requests {
                       const std::vector<Json::Node> &phones_json,
                       const std::vector<Json::Node> &urls_json,
                       const std::vector<Json::Node> &rubrics_json,
-                      const std::unordered_map<std::string, uint64_t> &rubric_ids_dict) : names_constraint_(names_json),
-                                                                                          phones_constraint_(phones_json),
-                                                                                          urls_constraint_(urls_json),
-                                                                                          rubrics_constraint_(rubrics_json, rubric_ids_dict) {}
+                      const std::vector<Json::Node> &datetime_json,
+                      const std::unordered_map<std::string, uint64_t> &rubric_ids_dict,
+                      bool explain = false) : names_constraint_(names_json),
+                                              phones_constraint_(phones_json),
+                                              urls_constraint_(urls_json),
+                                              rubrics_constraint_(rubrics_json, rubric_ids_dict),
+                                              working_time_constraint_(datetime_json),
+                                              explain_(explain) {}
+
+        std::vector<const YellowPagesDatabase::Company *> Search(const TransportCatalog &db, YellowPagesSearch::SearchPlan *plan = nullptr) const;
 
         Json::Dict Process(const TransportCatalog &db) const;
 
@@ -43,13 +56,53 @@ namespace Requests {
         YellowPagesSearch::CompanyPhoneConstraint phones_constraint_;
         YellowPagesSearch::CompanyUrlConstraint urls_constraint_;
         YellowPagesSearch::CompanyRubricConstraint rubrics_constraint_;
+        YellowPagesSearch::CompanyWorkingTimeConstraint working_time_constraint_;
+        bool explain_;  // add the executed search plan to the response as "plan"
+    };
+
+    struct RouteToCompany {
+        std::string stop_from;
+        FindCompanies companies;  // candidates
+
+        Json::Dict Process(const TransportCatalog &db) const;
+    };
+
+    // Nearest first; at most count of them if it is given, not farther than radius (in meters) if it is given
+    struct StopsNear {
+        Sphere::Point point;
+        std::optional<size_t> count;
+        std::optional<double> radius;
+
+        Json::Dict Process(const TransportCatalog &db) const;
+    };
+
+    struct CompaniesNear {
+        Sphere::Point point;
+        std::optional<size_t> count;
+        std::optional<double> radius;
+
+        Json::Dict Process(const TransportCatalog &db) const;
+    };
+
+    // Company names starting with query, or within max_edits of it if max_edits is given
+    struct SuggestCompanyNames {
+        std::string query;
+        std::optional<size_t> max_edits;
+        size_t limit;
+
+        Json::Dict Process(const TransportCatalog &db) const;
     };
 
     struct Map {
         Json::Dict Process(const TransportCatalog &db) const;
     };
 
-    std::variant<Stop, Bus, Route, FindCompanies, Map> Read(const Json::Dict &attrs);
+    // Hits, misses and evictions of the route render cache and of the companies search cache
+    struct CacheStats {
+        Json::Dict Process(const TransportCatalog &db) const;
+    };
+
+    std::variant<Stop, Bus, Route, FindCompanies, RouteToCompany, StopsNear, CompaniesNear, SuggestCompanyNames, Map, CacheStats> Read(const Json::Dict &attrs);
 
     std::vector<Json::Node> ProcessAll(const TransportCatalog &db, const std::vector<Json::Node> &requests);
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <optional>
+
 
 namespace Graph {
 
@@ -23,6 +25,9 @@ namespace Graph {
 
         std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+        // Weight of the best route without expanding it
+        std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const;
+
         EdgeId GetRouteEdge(RouteId route_id, size_t edge_idx) const;
 
         void ReleaseRoute(RouteId route_id);
@@ -134,6 +139,15 @@ namespace Graph {
         return RouteInfo{route_id, weight, route_edge_count};
     }
 
+    template<typename Weight>
+    std::optional<Weight> Router<Weight>::GetRouteWeight(VertexId from, VertexId to) const {
+        const auto &route_internal_data = routes_internal_data_[from][to];
+        if (!route_internal_data) {
+            return std::nullopt;
+        }
+        return route_internal_data->weight;
+    }
+
     template<typename Weight>
     EdgeId Router<Weight>::GetRouteEdge(RouteId route_id, size_t edge_idx) const {
         return expanded_routes_cache_.at(route_id)[edge_idx];
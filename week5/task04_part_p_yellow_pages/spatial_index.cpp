@@ -0,0 +1,122 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <limits>
+#include <queue>
+
+using namespace std;
+
+
+namespace {
+    double GetSplitCoordinate(Sphere::Point point, size_t depth) {
+        return depth % 2 == 0 ? point.latitude : point.longitude;
+    }
+
+    bool IsCloser(const SpatialIndex::FoundItem &lhs, const SpatialIndex::FoundItem &rhs) {
+        return tie(lhs.distance, lhs.id) < tie(rhs.distance, rhs.id);
+    }
+}
+
+class SpatialIndex::NearestItems {
+public:
+    NearestItems(optional<size_t> count, optional<double> radius) : count_(count), radius_(radius) {}
+
+    void Add(FoundItem item) {
+        if (radius_ && item.distance > *radius_) { return; }
+        if (count_ && items_.size() == *count_) {
+            if (*count_ == 0 || !IsCloser(item, items_.front())) { return; }
+            pop_heap(items_.begin(), items_.end(), IsCloser);
+            items_.pop_back();
+        }
+        items_.push_back(item);
+        if (count_) {
+            push_heap(items_.begin(), items_.end(), IsCloser);
+        }
+    }
+
+    // Items farther than that can not be added anymore
+    double GetDistanceLimit() const {
+        double limit = radius_ ? *radius_ : numeric_limits<double>::infinity();
+        if (count_ && items_.size() == *count_) {
+            limit = *count_ == 0 ? -1.0 : min(limit, items_.front().distance);
+        }
+        return limit;
+    }
+
+    vector<FoundItem> Release() && {
+        sort(items_.begin(), items_.end(), IsCloser);
+        return move(items_);
+    }
+
+private:
+    const optional<size_t> count_;
+    const optional<double> radius_;
+    vector<FoundItem> items_;  // max-heap by distance while count_ limits them
+};
+
+SpatialIndex::SpatialIndex(vector<Entry> entries) : entries_(move(entries)) {
+    Build(0, entries_.size(), 0);
+}
+
+SpatialIndex::SpatialIndex(const Serialization::SpatialIndex &serialization_spatial_index) {
+    entries_.reserve(serialization_spatial_index.entries_size());
+    for (const auto &serialization_entry : serialization_spatial_index.entries()) {
+        entries_.push_back({serialization_entry.id(), {serialization_entry.latitude(), serialization_entry.longitude()}});
+    }
+}
+
+void SpatialIndex::Build(size_t begin, size_t end, size_t depth) {
+    if (end - begin <= 1) { return; }
+
+    const size_t middle = begin + (end - begin) / 2;
+    nth_element(entries_.begin() + begin, entries_.begin() + middle, entries_.begin() + end,
+                [depth](const Entry &lhs, const Entry &rhs) {
+                    return GetSplitCoordinate(lhs.point, depth) < GetSplitCoordinate(rhs.point, depth);
+                });
+    Build(begin, middle, depth + 1);
+    Build(middle + 1, end, depth + 1);
+}
+
+vector<SpatialIndex::FoundItem> SpatialIndex::FindNearest(Sphere::Point point, optional<size_t> count, optional<double> radius) const {
+    NearestItems nearest_items(count, radius);
+    Search(0, entries_.size(), 0, point, nearest_items);
+    return move(nearest_items).Release();
+}
+
+void SpatialIndex::Search(size_t begin, size_t end, size_t depth, Sphere::Point point, NearestItems &nearest_items) const {
+    if (begin >= end) { return; }
+
+    const size_t middle = begin + (end - begin) / 2;
+    const Entry &entry = entries_[middle];
+    nearest_items.Add({entry.id, Sphere::Distance(point, entry.point)});
+
+    const bool is_point_before = GetSplitCoordinate(point, depth) < GetSplitCoordinate(entry.point, depth);
+    if (is_point_before) {
+        Search(begin, middle, depth + 1, point, nearest_items);
+    } else {
+        Search(middle + 1, end, depth + 1, point, nearest_items);
+    }
+
+    // The other side is behind the split line, and for longitudes also behind the antimeridian
+    const double other_side_distance = depth % 2 == 0
+                                       ? Sphere::DistanceToLatitude(point, entry.point.latitude)
+                                       : min(Sphere::DistanceToMeridian(point, entry.point.longitude), Sphere::DistanceToMeridian(point, 180.0));
+    if (other_side_distance > nearest_items.GetDistanceLimit() + DISTANCE_BOUND_SLACK) { return; }
+
+    if (is_point_before) {
+        Search(middle + 1, end, depth + 1, point, nearest_items);
+    } else {
+        Search(begin, middle, depth + 1, point, nearest_items);
+    }
+}
+
+Serialization::SpatialIndex SpatialIndex::SerializeSpatialIndex() const {
+    Serialization::SpatialIndex serialization_spatial_index;
+    for (const Entry &entry : entries_) {
+        Serialization::SpatialIndexEntry &serialization_entry = *serialization_spatial_index.add_entries();
+        serialization_entry.set_id(entry.id);
+        serialization_entry.set_latitude(entry.point.latitude);
+        serialization_entry.set_longitude(entry.point.longitude);
+    }
+    return serialization_spatial_index;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "sphere.h"
+#include "transport_catalog.pb.h"
+
+
+// Static 2-d tree over points on the sphere for radius and k-nearest queries
+class SpatialIndex {
+public:
+    using ItemId = uint32_t;
+
+    struct Entry {
+        ItemId id;
+        Sphere::Point point;  // in degrees
+    };
+
+    struct FoundItem {
+        ItemId id;
+        double distance;  // in meters
+    };
+
+    SpatialIndex() = default;
+
+    explicit SpatialIndex(std::vector<Entry> entries);
+
+    explicit SpatialIndex(const Serialization::SpatialIndex &serialization_spatial_index);
+
+    // Nearest items first, at most count of them if it is given, not farther than radius if it is given
+    std::vector<FoundItem> FindNearest(Sphere::Point point, std::optional<size_t> count, std::optional<double> radius) const;
+
+    Serialization::SpatialIndex SerializeSpatialIndex() const;
+
+private:
+    // Slack for the rounding of Sphere::Distance when pruning by the distance to a split line, in meters
+    static constexpr double DISTANCE_BOUND_SLACK = 1.0;
+
+    class NearestItems;
+
+    void Build(size_t begin, size_t end, size_t depth);
+
+    void Search(size_t begin, size_t end, size_t depth, Sphere::Point point, NearestItems &nearest_items) const;
+
+    // Implicit tree: the middle entry of a range is its root, with the entries before it on one side of the split and after it on the other.
+    // Ranges are split by latitude on even depths and by longitude on odd ones.
+    std::vector<Entry> entries_;
+};
@@ -28,4 +28,16 @@ namespace Sphere {
                 + cos(lhs.latitude) * cos(rhs.latitude) * cos(abs(lhs.longitude - rhs.longitude))
         ) * EARTH_RADIUS;
     }
+
+    double DistanceToLatitude(Point point, double latitude) {
+        return abs(ConvertDegreesToRadians(point.latitude - latitude)) * EARTH_RADIUS;
+    }
+
+    double DistanceToMeridian(Point point, double longitude) {
+        const double longitude_diff = abs(remainder(point.longitude - longitude, 360.0));
+        if (longitude_diff >= 90.0) {  // nearest is the pole
+            return (PI / 2 - abs(ConvertDegreesToRadians(point.latitude))) * EARTH_RADIUS;
+        }
+        return asin(sin(ConvertDegreesToRadians(longitude_diff)) * cos(ConvertDegreesToRadians(point.latitude))) * EARTH_RADIUS;
+    }
 }
@@ -16,13 +16,18 @@ namespace Sphere {
         }
     };
 
-    struct PointHash
+    struct PointLess
     {
-        size_t operator() (const Point &point) const
+        bool operator() (const Point &lhs, const Point &rhs) const
         {
-            return std::hash<double>()(point.latitude) ^ std::hash<double>()(point.longitude);
+            return lhs.latitude < rhs.latitude || (lhs.latitude == rhs.latitude && lhs.longitude < rhs.longitude);
         }
     };
 
     double Distance(Point lhs, Point rhs);
+
+    // Shortest distances from the point to the circle of latitude and to the half of meridian, in degrees as Distance
+    double DistanceToLatitude(Point point, double latitude);
+
+    double DistanceToMeridian(Point point, double longitude);
 }
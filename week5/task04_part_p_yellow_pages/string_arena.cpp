@@ -0,0 +1,31 @@
+#include "string_arena.h"
+
+#include <algorithm>
+
+using namespace std;
+
+
+string_view StringArena::Add(string_view str) {
+    if (str.empty()) {
+        return {};
+    }
+    char *data = Allocate(str.size());
+    copy(str.begin(), str.end(), data);
+    return {data, str.size()};
+}
+
+char *StringArena::Allocate(size_t size) {
+    if (size > block_free_) {
+        if (size > BLOCK_SIZE / 4) {  // a long string gets its own block, not to waste the rest of the current one
+            blocks_.push_back(make_unique<char[]>(size));
+            return blocks_.back().get();
+        }
+        blocks_.push_back(make_unique<char[]>(BLOCK_SIZE));
+        block_pos_ = blocks_.back().get();
+        block_free_ = BLOCK_SIZE;
+    }
+    char *data = block_pos_;
+    block_pos_ += size;
+    block_free_ -= size;
+    return data;
+}
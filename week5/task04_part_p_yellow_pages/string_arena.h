@@ -0,0 +1,21 @@
+#pragma once
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+
+// Strings kept in large blocks that never move, so that views to them stay valid
+class StringArena {
+public:
+    std::string_view Add(std::string_view str);
+
+private:
+    static constexpr size_t BLOCK_SIZE = 1 << 16;
+
+    char *Allocate(size_t size);
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char *block_pos_ = nullptr;
+    size_t block_free_ = 0;
+};
@@ -1,9 +1,98 @@
 #include "svg.h"
 
+#include <algorithm>
+#include <array>
+#include <charconv>
+
 using namespace std;
 
 namespace Svg {
 
+    // =============================== Formatting ==============================
+
+    string FormatNumber(double value, const RenderOptions &options) {
+        string result;
+        array<char, 128> buffer;
+        // general with precision 6 is what ostream prints by default
+        if (auto[ptr, ec] = options.precision ? to_chars(buffer.begin(), buffer.end(), value, chars_format::fixed, *options.precision) :
+                            to_chars(buffer.begin(), buffer.end(), value, chars_format::general, 6);
+                ec == errc()) {
+            result.assign(buffer.begin(), ptr);
+        } else {
+            stringstream ss;
+            ss << value;
+            result = ss.str();
+        }
+
+        if (options.minified) {
+            if (result.find('.') != string::npos && result.find('e') == string::npos) {
+                result.erase(result.find_last_not_of('0') + 1);
+                if (result.back() == '.') { result.pop_back(); }
+            }
+            if (result == "-0") { result = "0"; }
+        }
+        return result;
+    }
+
+    namespace {
+        const array<Attribute, 5> DEFAULT_ATTRIBUTES{{
+                {"fill", "black"},
+                {"stroke", "none"},
+                {"stroke-width", "1"},
+                {"dx", "0"},
+                {"dy", "0"},
+        }};
+
+        const array<const char *, 3> STROKE_ATTRIBUTE_NAMES{"stroke-width", "stroke-linecap", "stroke-linejoin"};
+
+        const array<const char *, 8> INHERITED_ATTRIBUTE_NAMES{"fill", "stroke", "stroke-width", "stroke-linecap", "stroke-linejoin",
+                                                               "font-family", "font-size", "font-weight"};
+
+        template<typename Container, typename T>
+        bool Contains(const Container &container, const T &value) {
+            return find(begin(container), end(container), value) != end(container);
+        }
+
+        bool HasAttributeNamed(const vector<Attribute> &attributes, const string &name) {
+            return any_of(attributes.begin(), attributes.end(), [&name](const Attribute &attribute) { return attribute.first == name; });
+        }
+
+        bool IsRedundantAttribute(const Attribute &attribute, const vector<Attribute> &all_attributes) {
+            if (Contains(DEFAULT_ATTRIBUTES, attribute)) {
+                return true;
+            }
+            return Contains(STROKE_ATTRIBUTE_NAMES, attribute.first) && Contains(all_attributes, Attribute{"stroke", "none"});
+        }
+
+        void RenderAttribute(string &out, const Attribute &attribute, const RenderOptions &options) {
+            if (options.minified) { out += ' '; }
+            out += attribute.first;
+            out += "=\"";
+            out += attribute.second;
+            out += '"';
+            if (!options.minified) { out += ' '; }
+        }
+    }
+
+    string RenderElement(const string &tag_name, const vector<Attribute> &attributes, const optional<string> &content,
+                         const RenderOptions &options, const vector<Attribute> &inherited_attributes) {
+        string result = "<" + tag_name;
+        if (!options.minified) { result += ' '; }
+        for (const auto &attribute : attributes) {
+            if (HasAttributeNamed(inherited_attributes, attribute.first)) { continue; }
+            if (options.minified && IsRedundantAttribute(attribute, attributes)) { continue; }
+            RenderAttribute(result, attribute, options);
+        }
+        if (content) {
+            result += ">" + *content + "</" + tag_name + ">";
+        } else {
+            result += "/>";
+        }
+        return result;
+    }
+
+    // =============================== RgbA ====================================
+
     RgbA::RgbA(std::initializer_list<uint8_t> in_list) {
         auto it = begin(in_list);
         red = *(it++);
@@ -65,14 +154,16 @@ namespace Svg {
         return *this;
     }
 
-    Circle::operator std::string() const {
-        std::stringstream ss;
-        ss << "<circle ";
-        ss << "cx=\"" << center_cx_cy.x << "\" cy=\"" << center_cx_cy.y << "\" ";
-        ss << "r=\"" << radius_r << "\" ";
-        ss << get_base_params_xml();
-        ss << "/>";
-        return ss.str();
+    vector<Attribute> Circle::GetAttributes(const RenderOptions &options) const {
+        vector<Attribute> attributes{
+                {"cx", FormatNumber(center_cx_cy.x, options)},
+                {"cy", FormatNumber(center_cx_cy.y, options)},
+                {"r",  FormatNumber(radius_r, options)},
+        };
+        for (auto &base_attribute : GetBaseAttributes(options)) {
+            attributes.push_back(move(base_attribute));
+        }
+        return attributes;
     }
 
     // =============================== Polyline ================================
@@ -82,17 +173,19 @@ namespace Svg {
         return *this;
     }
 
-    Polyline::operator std::string() const {
-        std::stringstream ss;
-        ss << "<polyline ";
-        ss << "points=\"";
+    vector<Attribute> Polyline::GetAttributes(const RenderOptions &options) const {
+        string points_str;
         for (const Point p : points) {
-            ss << p.x << "," << p.y << " ";
+            if (options.minified && !points_str.empty()) { points_str += ' '; }
+            points_str += FormatNumber(p.x, options) + "," + FormatNumber(p.y, options);
+            if (!options.minified) { points_str += ' '; }
+        }
+
+        vector<Attribute> attributes{{"points", move(points_str)}};
+        for (auto &base_attribute : GetBaseAttributes(options)) {
+            attributes.push_back(move(base_attribute));
         }
-        ss << "\" ";
-        ss << get_base_params_xml();
-        ss << "/>";
-        return ss.str();
+        return attributes;
     }
 
     // =============================== Text ====================================
@@ -127,23 +220,24 @@ namespace Svg {
         return *this;
     }
 
-    Text::operator std::string() const {
-        std::stringstream ss;
-        ss << "<text ";
-        ss << "x=\"" << x_y.x << "\" y=\"" << x_y.y << "\" ";
-        ss << "dx=\"" << dx_dy.x << "\" dy=\"" << dx_dy.y << "\" ";
-        ss << "font-size=\"" << font_size << "\" ";
+    vector<Attribute> Text::GetAttributes(const RenderOptions &options) const {
+        vector<Attribute> attributes{
+                {"x",         FormatNumber(x_y.x, options)},
+                {"y",         FormatNumber(x_y.y, options)},
+                {"dx",        FormatNumber(dx_dy.x, options)},
+                {"dy",        FormatNumber(dx_dy.y, options)},
+                {"font-size", FormatNumber(font_size, options)},
+        };
         if (font_family) {
-            ss << "font-family=\"" << *font_family << "\" ";
+            attributes.emplace_back("font-family", *font_family);
         }
         if (font_weight) {
-            ss << "font-weight=\"" << *font_weight << "\" ";
+            attributes.emplace_back("font-weight", *font_weight);
+        }
+        for (auto &base_attribute : GetBaseAttributes(options)) {
+            attributes.push_back(move(base_attribute));
         }
-        ss << get_base_params_xml();
-        ss << ">";
-        ss << text;
-        ss << "</text>";
-        return ss.str();
+        return attributes;
     }
 
     // =============================== Rect ====================================
@@ -158,28 +252,85 @@ namespace Svg {
         return *this;
     }
 
-    Rect::operator std::string() const {
-        std::stringstream ss;
-        ss << "<rect ";
-        ss << "x=\"" << center_cx_cy.x << "\" y=\"" << center_cx_cy.y << "\" ";
-        ss << "width=\"" << dimensions_w_h.x << "\" height=\"" << dimensions_w_h.y << "\" ";
-        ss << get_base_params_xml();
-        ss << "/>";
-        return ss.str();
+    vector<Attribute> Rect::GetAttributes(const RenderOptions &options) const {
+        vector<Attribute> attributes{
+                {"x",      FormatNumber(center_cx_cy.x, options)},
+                {"y",      FormatNumber(center_cx_cy.y, options)},
+                {"width",  FormatNumber(dimensions_w_h.x, options)},
+                {"height", FormatNumber(dimensions_w_h.y, options)},
+        };
+        for (auto &base_attribute : GetBaseAttributes(options)) {
+            attributes.push_back(move(base_attribute));
+        }
+        return attributes;
     }
 
     // =============================== Document ================================
 
-    void Document::Render(std::ostream &out) const {
-        out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>" << std::endl;
-        out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">" << std::endl;
-        for (const auto &node : svg_objects) {  // TODO: const unique_ptr<SvgObject> &node
-            out << std::visit([](const auto &node) {
-                                  return std::string(node);
+    void Document::Render(std::ostream &out, const RenderOptions &options) const {
+        RenderHeader(out, options);
+        RenderObjects(out, options);
+        RenderFooter(out, options);
+    }
+
+    void Document::RenderObjects(std::ostream &out, const RenderOptions &options) const {
+        if (!options.minified) {
+            for (const auto &node : svg_objects) {  // TODO: const unique_ptr<SvgObject> &node
+                out << std::visit([&options](const auto &node) {
+                                      return node.Render(options);
+                                  },
+                                  node) << std::endl;
+            }
+            return;
+        }
+
+        vector<vector<Attribute>> objects_attributes;
+        objects_attributes.reserve(svg_objects.size());
+        for (const auto &node : svg_objects) {
+            objects_attributes.push_back(std::visit([&options](const auto &node) { return node.GetAttributes(options); }, node));
+        }
+
+        // presentation attributes equal for all objects go to the enclosing <g>
+        vector<Attribute> shared_attributes;
+        if (svg_objects.size() > 1) {
+            for (const auto &attribute : objects_attributes.front()) {
+                if (Contains(INHERITED_ATTRIBUTE_NAMES, attribute.first) &&
+                    all_of(objects_attributes.begin(), objects_attributes.end(),
+                           [&attribute](const vector<Attribute> &attributes) { return Contains(attributes, attribute); })) {
+                    shared_attributes.push_back(attribute);
+                }
+            }
+        }
+
+        string group_open = "<g";
+        for (const auto &attribute : shared_attributes) {
+            if (!Contains(DEFAULT_ATTRIBUTES, attribute)) {
+                RenderAttribute(group_open, attribute, options);
+            }
+        }
+        const bool need_group = group_open.size() > 2;
+        if (need_group) {
+            out << group_open << ">";
+        }
+        for (size_t object_idx = 0; object_idx < svg_objects.size(); ++object_idx) {
+            out << std::visit([&](const auto &node) {
+                                  return RenderElement(node.GetTagName(), objects_attributes[object_idx], node.GetContent(), options, shared_attributes);
                               },
-                              node) << std::endl;
+                              svg_objects[object_idx]);
         }
-        out << "</svg>" << std::endl;
+        if (need_group) {
+            out << "</g>";
+        }
+    }
+
+    void Document::RenderHeader(std::ostream &out, const RenderOptions &options) {
+        const char *line_end = options.minified ? "" : "\n";
+        out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>" << line_end;
+        out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">" << line_end;
+    }
+
+    void Document::RenderFooter(std::ostream &out, const RenderOptions &options) {
+        out << "</svg>" << (options.minified ? "" : "\n");
     }
 }
 
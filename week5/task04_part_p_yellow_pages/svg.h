@@ -15,6 +15,21 @@ namespace Svg {
         double x, y;
     };
 
+    struct RenderOptions {
+        static constexpr int MAX_PRECISION = 17;  // enough for every double
+
+        std::optional<int> precision = std::nullopt;  // digits after the decimal point; stream default if not set
+        bool minified = false;  // shortest numbers, no default attributes and whitespace, attributes shared by a Document in <g>
+    };
+
+    std::string FormatNumber(double value, const RenderOptions &options);
+
+    using Attribute = std::pair<std::string, std::string>;
+
+    // Attributes listed in inherited_attributes are set by the enclosing <g> and are skipped
+    std::string RenderElement(const std::string &tag_name, const std::vector<Attribute> &attributes, const std::optional<std::string> &content,
+                              const RenderOptions &options, const std::vector<Attribute> &inherited_attributes);
+
     struct RgbA {
         RgbA(std::initializer_list<uint8_t> c);
 
@@ -80,17 +95,28 @@ namespace Svg {
             return static_cast<Derived_T &>(*this);
         }
 
-        std::string get_base_params_xml() const {
-            std::stringstream ss;
-            ss << "fill=\"" + std::string(fill) + "\" ";
-            ss << "stroke=\"" + std::string(stroke) + "\" ";
-            ss << "stroke-width=\"" + std::to_string(stroke_width) + "\" ";
-            if (stroke_linecap) { ss << "stroke-linecap=\"" + *stroke_linecap + "\" "; }
-            if (stroke_linejoin) { ss << "stroke-linejoin=\"" + *stroke_linejoin + "\" "; }
-            return ss.str();
+        std::vector<Attribute> GetBaseAttributes(const RenderOptions &options) const {
+            std::vector<Attribute> attributes{
+                    {"fill",         std::string(fill)},
+                    {"stroke",       std::string(stroke)},
+                    {"stroke-width", options.precision || options.minified ? FormatNumber(stroke_width, options) : std::to_string(stroke_width)},
+            };
+            if (stroke_linecap) { attributes.emplace_back("stroke-linecap", *stroke_linecap); }
+            if (stroke_linejoin) { attributes.emplace_back("stroke-linejoin", *stroke_linejoin); }
+            return attributes;
         }
 
-        virtual explicit operator std::string() const = 0;
+        virtual std::string GetTagName() const = 0;
+
+        virtual std::vector<Attribute> GetAttributes(const RenderOptions &options) const = 0;
+
+        virtual std::optional<std::string> GetContent() const { return std::nullopt; }  // element is self-closing if none
+
+        std::string Render(const RenderOptions &options, const std::vector<Attribute> &inherited_attributes = {}) const {
+            return RenderElement(GetTagName(), GetAttributes(options), GetContent(), options, inherited_attributes);
+        }
+
+        explicit operator std::string() const { return Render({}); }
 
     private:
         Color fill;
@@ -107,7 +133,9 @@ namespace Svg {
 
         Circle &SetRadius(double r);
 
-        explicit operator std::string() const override;
+        std::string GetTagName() const override { return "circle"; }
+
+        std::vector<Attribute> GetAttributes(const RenderOptions &options) const override;
 
     private:
         Point center_cx_cy{0.0, 0.0};
@@ -118,7 +146,9 @@ namespace Svg {
     public:
         Polyline &AddPoint(Point p);
 
-        explicit operator std::string() const override;
+        std::string GetTagName() const override { return "polyline"; }
+
+        std::vector<Attribute> GetAttributes(const RenderOptions &options) const override;
 
     private:
         std::vector<Point> points;
@@ -138,7 +168,11 @@ namespace Svg {
 
         Text &SetData(const std::string &data);
 
-        explicit operator std::string() const override;
+        std::string GetTagName() const override { return "text"; }
+
+        std::vector<Attribute> GetAttributes(const RenderOptions &options) const override;
+
+        std::optional<std::string> GetContent() const override { return text; }
 
     private:
         Point x_y{0.0, 0.0}, dx_dy{0.0, 0.0};
@@ -154,7 +188,9 @@ namespace Svg {
 
         Rect &SetDimensions(Point p);
 
-        explicit operator std::string() const override;
+        std::string GetTagName() const override { return "rect"; }
+
+        std::vector<Attribute> GetAttributes(const RenderOptions &options) const override;
 
     private:
         Point center_cx_cy{0.0, 0.0};
@@ -168,7 +204,13 @@ namespace Svg {
             svg_objects.emplace_back(std::move(svg_object));
         }
 
-        void Render(std::ostream &out) const;
+        void Render(std::ostream &out, const RenderOptions &options = {}) const;
+
+        void RenderObjects(std::ostream &out, const RenderOptions &options = {}) const;
+
+        static void RenderHeader(std::ostream &out, const RenderOptions &options = {});
+
+        static void RenderFooter(std::ostream &out, const RenderOptions &options = {});
 
     private:
         std::vector<std::variant<Circle, Polyline, Text, Rect>> svg_objects;
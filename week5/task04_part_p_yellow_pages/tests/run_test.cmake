@@ -0,0 +1,38 @@
+# cmake -DPROGRAM=<task04_part_p_yellow_pages> -DTESTS_DIR=<tests> -DTEST_NAME=<name> -P run_test.cmake
+# Makes the base of <name>_make_base.json, of make_base.json if there is none, and processes <name>.json with it,
+# the output must be <name>_expected.json.
+# The base file of the inputs, base.bin, is renamed to <name>.bin, so that the tests may run in parallel.
+
+function(read_input file result)
+    file(READ ${TESTS_DIR}/${file} input)
+    string(REPLACE "\"base.bin\"" "\"${TEST_NAME}.bin\"" input "${input}")
+    set(${result} "${input}" PARENT_SCOPE)
+endfunction()
+
+function(run_mode mode input_file)
+    read_input(${input_file} input)
+    file(WRITE ${TEST_NAME}_${mode}.json "${input}")
+    execute_process(
+            COMMAND ${PROGRAM} ${mode}
+            INPUT_FILE ${TEST_NAME}_${mode}.json
+            OUTPUT_VARIABLE output
+            RESULT_VARIABLE result
+    )
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "${mode} of ${input_file} failed: ${result}")
+    endif ()
+    set(output "${output}" PARENT_SCOPE)
+endfunction()
+
+if (EXISTS ${TESTS_DIR}/${TEST_NAME}_make_base.json)
+    run_mode(make_base ${TEST_NAME}_make_base.json)
+else ()
+    run_mode(make_base make_base.json)
+endif ()
+run_mode(process_requests ${TEST_NAME}.json)
+
+file(READ ${TESTS_DIR}/${TEST_NAME}_expected.json expected)
+if (NOT output STREQUAL expected)
+    file(WRITE ${TEST_NAME}_output.json "${output}")
+    message(FATAL_ERROR "The output of ${TEST_NAME}.json differs from ${TEST_NAME}_expected.json, see ${CMAKE_CURRENT_BINARY_DIR}/${TEST_NAME}_output.json")
+endif ()
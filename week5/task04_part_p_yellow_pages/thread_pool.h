@@ -0,0 +1,82 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+// Fixed set of worker threads running submitted tasks in submission order
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t thread_count);
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool();
+
+    template<typename Func>
+    std::future<std::invoke_result_t<Func>> Submit(Func func);
+
+private:
+    void RunWorker();
+
+    std::mutex mutex_;
+    std::condition_variable task_added_;
+    std::queue<std::function<void()>> tasks_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+
+inline ThreadPool::ThreadPool(size_t thread_count) {
+    workers_.reserve(thread_count);
+    for (size_t idx = 0; idx < thread_count; ++idx) {
+        workers_.emplace_back([this] { RunWorker(); });
+    }
+}
+
+inline ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        stopping_ = true;
+    }
+    task_added_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+}
+
+template<typename Func>
+std::future<std::invoke_result_t<Func>> ThreadPool::Submit(Func func) {
+    // std::function needs a copyable target, so the move-only task is shared
+    auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Func>()>>(std::move(func));
+    auto result = task->get_future();
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        tasks_.emplace([task] { (*task)(); });
+    }
+    task_added_.notify_one();
+    return result;
+}
+
+inline void ThreadPool::RunWorker() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            task_added_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) { return; }
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+        task();
+    }
+}
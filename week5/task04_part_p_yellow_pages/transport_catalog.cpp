@@ -36,6 +36,32 @@ TransportCatalog::TransportCatalog(vector<Descriptions::InputQuery> data, const
     router_ = make_unique<TransportRouter>(stops_dict, buses_dict, routing_settings_json);
 
     yellow_pages_ = YellowPagesDatabase::YellowPagesDb(yellow_pages_json);
+
+    vector<SpatialIndex::Entry> stop_entries;
+    stop_entries.reserve(stops_dict.size());
+    for (const auto &[stop_name, stop] : stops_dict) {
+        stop_entries.push_back({static_cast<SpatialIndex::ItemId>(spatial_stop_names_.size()), stop->position});
+        spatial_stop_names_.push_back(stop_name);
+    }
+    stops_spatial_index_ = SpatialIndex(move(stop_entries));
+
+    vector<SpatialIndex::Entry> company_entries;
+    const auto &companies = yellow_pages_.get_companies();
+    for (size_t company_id = 0; company_id < companies.size(); ++company_id) {
+        const auto &company_address = companies[company_id].get_company_address();
+        if (company_address && company_address->get_coords()) {
+            company_entries.push_back({static_cast<SpatialIndex::ItemId>(company_id), *company_address->get_coords()});
+        }
+    }
+    companies_spatial_index_ = SpatialIndex(move(company_entries));
+
+    vector<pair<string, NamesTrie::ItemId>> company_names;
+    for (size_t company_id = 0; company_id < companies.size(); ++company_id) {
+        for (const auto &company_name : companies[company_id].get_company_names()) {
+            company_names.emplace_back(company_name.get_name(), company_id);
+        }
+    }
+    company_names_trie_ = NamesTrie(move(company_names));
 }
 
 TransportCatalog::TransportCatalog(const Serialization::TransportCatalog &serialization_base) {
@@ -65,6 +91,12 @@ TransportCatalog::TransportCatalog(const Serialization::TransportCatalog &serial
     map_renderer_ = MapRenderer(serialization_base.map_renderer());
 
     yellow_pages_ = YellowPagesDatabase::YellowPagesDb(serialization_base.yellow_pages());
+
+    spatial_stop_names_.assign(serialization_base.spatial_stop_names().begin(), serialization_base.spatial_stop_names().end());
+    stops_spatial_index_ = SpatialIndex(serialization_base.stops_spatial_index());
+    companies_spatial_index_ = SpatialIndex(serialization_base.companies_spatial_index());
+
+    company_names_trie_ = NamesTrie(serialization_base.company_names_trie());
 }
 
 const TransportCatalog::Stop *TransportCatalog::GetStop(const string &name) const {
@@ -83,16 +115,90 @@ std::string TransportCatalog::RenderMap() const {
     return map_renderer_.RenderMap();
 }
 
-std::string TransportCatalog::RenderRoute(const std::vector<TransportRouter::RouteInfo::BusItem> &items) const {
+std::shared_ptr<const std::string> TransportCatalog::RenderRoute(const std::vector<TransportRouter::RouteInfo::BusItem> &items) const {
     return map_renderer_.RenderRoute(items);
 }
 
+RouteGeometry TransportCatalog::BuildRouteGeometry(const std::vector<TransportRouter::RouteInfo::BusItem> &items) const {
+    return map_renderer_.BuildRouteGeometry(items);
+}
+
 const std::unordered_map<std::string, uint64_t> &TransportCatalog::get_rubric_ids_dict() const {
     return yellow_pages_.get_rubric_ids_dict();
 }
 
-std::vector<const YellowPagesDatabase::Company *> TransportCatalog::SearchCompanies(const array<const YellowPagesSearch::CompanyConstraint *, 4> &companies_constraints) const {
-    return yellow_pages_.SearchCompanies(companies_constraints);
+optional<TransportCatalog::CompanyRouteInfo> TransportCatalog::FindRouteToCompany(const string &stop_from,
+                                                                                   const vector<const YellowPagesDatabase::Company *> &companies) const {
+    vector<TransportRouter::RouteTarget> targets;
+    vector<const YellowPagesDatabase::Company *> target_companies;
+    for (const auto company_ptr : companies) {
+        for (const auto &nearby_stop : company_ptr->get_company_nearby_stops()) {
+            targets.push_back({string(nearby_stop.name), static_cast<double>(nearby_stop.meters)});
+            target_companies.push_back(company_ptr);
+        }
+    }
+
+    auto target_route = router_->FindRouteToNearestTarget(stop_from, targets);
+    if (!target_route) {
+        return nullopt;
+    }
+    return CompanyRouteInfo{
+            target_companies[target_route->target_idx],
+            targets[target_route->target_idx].stop_name,
+            move(target_route->route),
+            target_route->walk_time,
+    };
+}
+
+vector<TransportCatalog::StopNear> TransportCatalog::FindStopsNear(Sphere::Point point, optional<size_t> count, optional<double> radius) const {
+    vector<StopNear> stops_near;
+    for (const auto &found_item : stops_spatial_index_.FindNearest(point, count, radius)) {
+        stops_near.push_back({spatial_stop_names_[found_item.id], found_item.distance});
+    }
+    return stops_near;
+}
+
+vector<TransportCatalog::CompanyNear> TransportCatalog::FindCompaniesNear(Sphere::Point point, optional<size_t> count, optional<double> radius) const {
+    vector<CompanyNear> companies_near;
+    for (const auto &found_item : companies_spatial_index_.FindNearest(point, count, radius)) {
+        companies_near.push_back({&yellow_pages_.get_companies()[found_item.id], found_item.distance});
+    }
+    return companies_near;
+}
+
+vector<TransportCatalog::CompanyNameMatch> TransportCatalog::FindCompanyNamesByPrefix(string_view prefix, size_t limit) const {
+    return MakeCompanyNameMatches(company_names_trie_.FindByPrefix(prefix, limit));
+}
+
+vector<TransportCatalog::CompanyNameMatch> TransportCatalog::FindSimilarCompanyNames(string_view name, size_t max_edits, size_t limit) const {
+    return MakeCompanyNameMatches(company_names_trie_.FindSimilar(name, max_edits, limit));
+}
+
+vector<TransportCatalog::CompanyNameMatch> TransportCatalog::MakeCompanyNameMatches(const vector<NamesTrie::FoundName> &found_names) const {
+    vector<CompanyNameMatch> matches;
+    matches.reserve(found_names.size());
+    for (const auto &found_name : found_names) {
+        auto &match = matches.emplace_back();
+        match.name = company_names_trie_.GetName(found_name.name_idx);
+        match.distance = found_name.distance;
+        for (const auto company_id : company_names_trie_.GetItems(found_name.name_idx)) {
+            match.companies.push_back(&yellow_pages_.get_companies()[company_id]);
+        }
+    }
+    return matches;
+}
+
+std::vector<const YellowPagesDatabase::Company *> TransportCatalog::SearchCompanies(const YellowPagesSearch::CompanyConstraints &companies_constraints,
+                                                                                   YellowPagesSearch::SearchPlan *plan) const {
+    return yellow_pages_.SearchCompanies(companies_constraints, plan);
+}
+
+LruCacheStats TransportCatalog::GetRouteRenderCacheStats() const {
+    return map_renderer_.GetRouteRenderCacheStats();
+}
+
+LruCacheStats TransportCatalog::GetCompaniesSearchCacheStats() const {
+    return yellow_pages_.GetSearchCacheStats();
 }
 
 Serialization::TransportCatalog TransportCatalog::SerializeBase() const {
@@ -125,6 +231,14 @@ Serialization::TransportCatalog TransportCatalog::SerializeBase() const {
 
     *serialization_base.mutable_yellow_pages() = yellow_pages_.SerializeYellowPages();
 
+    for (const auto &stop_name : spatial_stop_names_) {
+        serialization_base.add_spatial_stop_names(stop_name);
+    }
+    *serialization_base.mutable_stops_spatial_index() = stops_spatial_index_.SerializeSpatialIndex();
+    *serialization_base.mutable_companies_spatial_index() = companies_spatial_index_.SerializeSpatialIndex();
+
+    *serialization_base.mutable_company_names_trie() = company_names_trie_.SerializeNamesTrie();
+
     return serialization_base;
 }
 
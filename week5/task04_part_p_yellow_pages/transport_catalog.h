@@ -10,6 +10,8 @@
 
 #include "descriptions.h"
 #include "map_renderer.h"
+#include "names_trie.h"
+#include "spatial_index.h"
 #include "transport_router.h"
 #include "yellow_pages.h"
 
@@ -44,15 +46,61 @@ public:
 
     std::string RenderMap() const;
 
-    std::string RenderRoute(const std::vector<TransportRouter::RouteInfo::BusItem> &items) const;
+    std::shared_ptr<const std::string> RenderRoute(const std::vector<TransportRouter::RouteInfo::BusItem> &items) const;
+
+    RouteGeometry BuildRouteGeometry(const std::vector<TransportRouter::RouteInfo::BusItem> &items) const;
 
     const std::unordered_map<std::string, uint64_t> &get_rubric_ids_dict() const;
 
-    std::vector<const YellowPagesDatabase::Company *> SearchCompanies(const std::array<const YellowPagesSearch::CompanyConstraint *, 4> &companies_constraints) const;
+    struct CompanyRouteInfo {
+        const YellowPagesDatabase::Company *company;
+        std::string stop_name;  // nearby stop of the company where the route ends
+        TransportRouter::RouteInfo route;
+        double walk_time;  // from the stop to the company, in minutes
+    };
+
+    // Fastest route to any of the companies through their nearby stops
+    std::optional<CompanyRouteInfo> FindRouteToCompany(const std::string &stop_from, const std::vector<const YellowPagesDatabase::Company *> &companies) const;
+
+    struct StopNear {
+        std::string name;
+        double distance;  // in meters
+    };
+
+    struct CompanyNear {
+        const YellowPagesDatabase::Company *company;
+        double distance;  // in meters
+    };
+
+    // Nearest first, at most count of them if it is given, not farther than radius if it is given
+    std::vector<StopNear> FindStopsNear(Sphere::Point point, std::optional<size_t> count, std::optional<double> radius) const;
+
+    // Only companies with coords in their address
+    std::vector<CompanyNear> FindCompaniesNear(Sphere::Point point, std::optional<size_t> count, std::optional<double> radius) const;
+
+    struct CompanyNameMatch {
+        std::string name;
+        size_t distance;  // edits from the query, 0 for prefix matches
+        std::vector<const YellowPagesDatabase::Company *> companies;  // having the name among their names
+    };
+
+    // Company names starting with the prefix, in lexicographical order
+    std::vector<CompanyNameMatch> FindCompanyNamesByPrefix(std::string_view prefix, size_t limit) const;
+
+    // Company names within max_edits of the name, nearest first
+    std::vector<CompanyNameMatch> FindSimilarCompanyNames(std::string_view name, size_t max_edits, size_t limit) const;
+
+    std::vector<const YellowPagesDatabase::Company *> SearchCompanies(const YellowPagesSearch::CompanyConstraints &companies_constraints,
+                                                                      YellowPagesSearch::SearchPlan *plan = nullptr) const;
+
+    LruCacheStats GetRouteRenderCacheStats() const;
+
+    LruCacheStats GetCompaniesSearchCacheStats() const;
 
     Serialization::TransportCatalog SerializeBase() const;
 
 private:
+    std::vector<CompanyNameMatch> MakeCompanyNameMatches(const std::vector<NamesTrie::FoundName> &found_names) const;
 
     static int ComputeRoadRouteLength(
             const std::vector<std::string> &stops,
@@ -71,4 +119,10 @@ private:
     std::unique_ptr<TransportRouter> router_;
 
     YellowPagesDatabase::YellowPagesDb yellow_pages_;
+
+    std::vector<std::string> spatial_stop_names_;  // by ids of stops_spatial_index_
+    SpatialIndex stops_spatial_index_;
+    SpatialIndex companies_spatial_index_;  // by company ids
+
+    NamesTrie company_names_trie_;  // all names of the companies, by company ids
 };
@@ -24,7 +24,10 @@ TransportRouter::TransportRouter(const Serialization::TransportRouter &serializa
 //    repeated VertexInfo vertices_info = 4;
 //    repeated EdgeType edge_types = 5;
 //    repeated BusEdgeInfo bus_edge_infos = 6;
-    routing_settings_ = {serialization_router.routing_settings().bus_wait_time(), serialization_router.routing_settings().bus_velocity()};
+    // Bases made before the pedestrian velocity was kept have none
+    const double pedestrian_velocity = serialization_router.routing_settings().pedestrian_velocity();
+    routing_settings_ = {serialization_router.routing_settings().bus_wait_time(), serialization_router.routing_settings().bus_velocity(),
+                         pedestrian_velocity > 0 ? pedestrian_velocity : RoutingSettings::DEFAULT_PEDESTRIAN_VELOCITY};
     graph_ = BusGraph(serialization_router.bus_graph());
 
     stops_vertex_ids_.reserve(serialization_router.stops_vertex_ids_size());
@@ -64,9 +67,14 @@ TransportRouter::TransportRouter(const Serialization::TransportRouter &serializa
 }
 
 TransportRouter::RoutingSettings TransportRouter::MakeRoutingSettings(const Json::Dict &json) {
+    const double pedestrian_velocity = json.count("pedestrian_velocity") ? json.at("pedestrian_velocity").AsDouble() : RoutingSettings::DEFAULT_PEDESTRIAN_VELOCITY;
+    if (pedestrian_velocity <= 0) {
+        throw invalid_argument("TransportRouter::MakeRoutingSettings: pedestrian_velocity is not positive");
+    }
     return {
             json.at("bus_wait_time").AsInt(),
             json.at("bus_velocity").AsDouble(),
+            pedestrian_velocity,
     };
 }
 
@@ -168,6 +176,42 @@ optional<TransportRouter::RouteInfo> TransportRouter::FindRoute(const string &st
     return route_info;
 }
 
+optional<TransportRouter::TargetRouteInfo> TransportRouter::FindRouteToNearestTarget(const string &stop_from, const vector<RouteTarget> &targets) const {
+    // Router keeps the weights of all the routes, so the targets are compared by lookups and only the best route is expanded
+    auto vertex_ids_from_it = stops_vertex_ids_.find(stop_from);
+    if (vertex_ids_from_it == stops_vertex_ids_.end()) {
+        return nullopt;
+    }
+    const Graph::VertexId vertex_from = vertex_ids_from_it->second.out;
+    const double pedestrian_meters_per_minute = routing_settings_.pedestrian_velocity * 1000.0 / 60;
+
+    optional<size_t> best_target_idx;
+    double best_total_time = 0;
+    for (size_t target_idx = 0; target_idx < targets.size(); ++target_idx) {
+        auto vertex_ids_it = stops_vertex_ids_.find(targets[target_idx].stop_name);
+        if (vertex_ids_it == stops_vertex_ids_.end()) { continue; }
+
+        const auto route_time = router_->GetRouteWeight(vertex_from, vertex_ids_it->second.out);
+        if (!route_time) { continue; }
+
+        const double total_time = *route_time + targets[target_idx].walk_distance / pedestrian_meters_per_minute;
+        if (!best_target_idx || total_time < best_total_time) {
+            best_target_idx = target_idx;
+            best_total_time = total_time;
+        }
+    }
+    if (!best_target_idx) {
+        return nullopt;
+    }
+
+    const RouteTarget &best_target = targets[*best_target_idx];
+    return TargetRouteInfo{
+            *best_target_idx,
+            *FindRoute(stop_from, best_target.stop_name),
+            best_target.walk_distance / pedestrian_meters_per_minute,
+    };
+}
+
 Serialization::TransportRouter TransportRouter::SerializeRouter() const {
     Serialization::TransportRouter serialization_router;
 
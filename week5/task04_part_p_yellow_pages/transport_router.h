@@ -41,17 +41,36 @@ public:
 
     std::optional<RouteInfo> FindRoute(const std::string &stop_from, const std::string &stop_to) const;
 
+    // Place reachable on foot from a stop
+    struct RouteTarget {
+        std::string stop_name;
+        double walk_distance;  // in meters
+    };
+
+    struct TargetRouteInfo {
+        size_t target_idx;
+        RouteInfo route;  // to the stop of the target
+        double walk_time;  // from the stop to the target, in minutes
+    };
+
+    // Fastest route to any of the targets, walking included; the earliest target on ties
+    std::optional<TargetRouteInfo> FindRouteToNearestTarget(const std::string &stop_from, const std::vector<RouteTarget> &targets) const;
+
     Serialization::TransportRouter SerializeRouter() const;
 
 private:
     struct RoutingSettings {
+        static constexpr double DEFAULT_PEDESTRIAN_VELOCITY = 4.0;
+
         int bus_wait_time;  // in minutes
         double bus_velocity;  // km/h
+        double pedestrian_velocity;  // km/h
 
         Serialization::RoutingSettings SerializeRoutingSettings() const {
             Serialization::RoutingSettings serialization_routingSettings;
             serialization_routingSettings.set_bus_wait_time(bus_wait_time);
             serialization_routingSettings.set_bus_velocity(bus_velocity);
+            serialization_routingSettings.set_pedestrian_velocity(pedestrian_velocity);
             return serialization_routingSettings;
         }
     };
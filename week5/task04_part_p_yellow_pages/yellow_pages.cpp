@@ -1,24 +1,57 @@
 #include "yellow_pages.h"
 
+#include <algorithm>
+
 
 namespace YellowPagesDatabase {
-    CompanyAddress::CompanyAddress(const Json::Dict &company_address_json) {
-//        if (company_address_json.count("formatted")) {
-        formatted_ = company_address_json.at("formatted").AsString();
-//        }
-//        if (company_address_json.count("coords")) {
-        coords_ = {company_address_json.at("coords").AsMap().at("lat").AsDouble(), company_address_json.at("coords").AsMap().at("lat").AsDouble()};
-//        }
-//        if (company_address_json.count("comment")) {
-        comment_ = company_address_json.at("comment").AsString();
-//        }
-    }
-
-//    CompanyAddress::CompanyAddress(const YellowPages::Address &serialization_company_address) {
-//    }
-
-    CompanyName::CompanyName(const Json::Dict &company_name_json) {
-        value_ = company_name_json.at("value").AsString();
+    namespace {
+        // Empty strings are absent values
+        std::optional<std::string_view> AddOptionalString(StringArena &strings, const std::string &str) {
+            return str.empty() ? std::nullopt : std::optional(strings.Add(str));
+        }
+
+        std::optional<std::string_view> AddOptionalString(StringArena &strings, const Json::Dict &json, const std::string &key) {
+            return json.count(key) ? AddOptionalString(strings, json.at(key).AsString()) : std::nullopt;
+        }
+
+        std::string ToString(const std::optional<std::string_view> &str) {
+            return str.has_value() ? std::string(*str) : "";
+        }
+    }
+
+    CompanyAddress::CompanyAddress(const Json::Dict &company_address_json, StringArena &strings) {
+        formatted_ = AddOptionalString(strings, company_address_json, "formatted");
+        if (company_address_json.count("coords")) {
+            coords_ = {company_address_json.at("coords").AsMap().at("lat").AsDouble(), company_address_json.at("coords").AsMap().at("lon").AsDouble()};
+        }
+        comment_ = AddOptionalString(strings, company_address_json, "comment");
+    }
+
+    CompanyAddress::CompanyAddress(const YellowPages::Address &serialization_company_address, StringArena &strings) {
+        formatted_ = AddOptionalString(strings, serialization_company_address.formatted());
+        if (serialization_company_address.has_coords()) {
+            coords_ = {serialization_company_address.coords().lat(), serialization_company_address.coords().lon()};
+        }
+        comment_ = AddOptionalString(strings, serialization_company_address.comment());
+    }
+
+    const std::optional<Sphere::Point> &CompanyAddress::get_coords() const {
+        return coords_;
+    }
+
+    YellowPages::Address CompanyAddress::SerializeAddress() const {
+        YellowPages::Address serialization_address;
+        serialization_address.set_formatted(ToString(formatted_));
+        if (coords_) {
+            serialization_address.mutable_coords()->set_lat(coords_->latitude);
+            serialization_address.mutable_coords()->set_lon(coords_->longitude);
+        }
+        serialization_address.set_comment(ToString(comment_));
+        return serialization_address;
+    }
+
+    CompanyName::CompanyName(const Json::Dict &company_name_json, StringArena &strings) {
+        value_ = strings.Add(company_name_json.at("value").AsString());
         if (!company_name_json.count("type") || company_name_json.at("type").AsString().empty() || company_name_json.at("type").AsString() == "MAIN") {
             type_ = ::YellowPages::Name_Type::Name_Type_MAIN;
         } else if (company_name_json.at("type").AsString() == "SHORT") {
@@ -28,12 +61,12 @@ namespace YellowPagesDatabase {
         }
     }
 
-    CompanyName::CompanyName(const ::YellowPages::Name &serialization_company_name) {
-        value_ = serialization_company_name.value();
+    CompanyName::CompanyName(const ::YellowPages::Name &serialization_company_name, StringArena &strings) {
+        value_ = strings.Add(serialization_company_name.value());
         type_ = serialization_company_name.type();
     }
 
-    const std::string &CompanyName::get_name() const {
+    std::string_view CompanyName::get_name() const {
         return value_;
     }
 
@@ -43,166 +76,361 @@ namespace YellowPagesDatabase {
 
     ::YellowPages::Name CompanyName::SerializeName() const {
         ::YellowPages::Name serialization_name;
-        serialization_name.set_value(value_);
+        serialization_name.set_value(std::string(value_));
         serialization_name.set_type(type_);
         return serialization_name;
     }
 
-    CompanyPhone::CompanyPhone(const Json::Dict &company_phone_json) {
-        if (company_phone_json.count("formatted") && !company_phone_json.at("formatted").AsString().empty()) {
-            formatted_ = company_phone_json.at("formatted").AsString();
-        }
+    CompanyPhone::CompanyPhone(const Json::Dict &company_phone_json, StringArena &strings) {
+        formatted_ = AddOptionalString(strings, company_phone_json, "formatted");
         if (!company_phone_json.count("type") || company_phone_json.at("type").AsString() == "PHONE") {
             type_ = ::YellowPages::Phone_Type::Phone_Type_PHONE;
         } else if (company_phone_json.count("type") && company_phone_json.at("type").AsString() == "FAX") {
             type_ = ::YellowPages::Phone_Type::Phone_Type_FAX;
         } else {
-            throw std::runtime_error("CompanyPhone::CompanyPhone(const Json::Dict &company_phone_json)");
+            throw std::runtime_error("CompanyPhone::CompanyPhone(const Json::Dict &company_phone_json, StringArena &strings)");
         }
 
-        if (company_phone_json.count("country_code") && !company_phone_json.at("country_code").AsString().empty()) {
-            country_code_ = company_phone_json.at("country_code").AsString();
-        }
-        if (company_phone_json.count("local_code") && !company_phone_json.at("local_code").AsString().empty()) {
-            local_code_ = company_phone_json.at("local_code").AsString();
-        }
-        if (company_phone_json.count("number") && !company_phone_json.at("number").AsString().empty()) {
-            number_ = company_phone_json.at("number").AsString();
-        }
-        if (company_phone_json.count("extension") && !company_phone_json.at("extension").AsString().empty()) {
-            extension_ = company_phone_json.at("extension").AsString();
-        }
-        if (company_phone_json.count("description") && !company_phone_json.at("description").AsString().empty()) {
-            description_ = company_phone_json.at("description").AsString();
-        }
+        country_code_ = AddOptionalString(strings, company_phone_json, "country_code");
+        local_code_ = AddOptionalString(strings, company_phone_json, "local_code");
+        number_ = AddOptionalString(strings, company_phone_json, "number");
+        extension_ = AddOptionalString(strings, company_phone_json, "extension");
+        description_ = AddOptionalString(strings, company_phone_json, "description");
     }
 
-    CompanyPhone::CompanyPhone(const ::YellowPages::Phone &serialization_company_phone) {
-        formatted_ = serialization_company_phone.formatted().empty() ? std::nullopt : std::optional(serialization_company_phone.formatted());
+    CompanyPhone::CompanyPhone(const ::YellowPages::Phone &serialization_company_phone, StringArena &strings) {
+        formatted_ = AddOptionalString(strings, serialization_company_phone.formatted());
         type_ = serialization_company_phone.type();
-        country_code_ = serialization_company_phone.country_code().empty() ? std::nullopt : std::optional(serialization_company_phone.country_code());
-        local_code_ = serialization_company_phone.local_code().empty() ? std::nullopt : std::optional(serialization_company_phone.local_code());
-        number_ = serialization_company_phone.number().empty() ? std::nullopt : std::optional(serialization_company_phone.number());
-        extension_ = serialization_company_phone.extension().empty() ? std::nullopt : std::optional(serialization_company_phone.extension());
-        description_ = serialization_company_phone.description().empty() ? std::nullopt : std::optional(serialization_company_phone.description());
+        country_code_ = AddOptionalString(strings, serialization_company_phone.country_code());
+        local_code_ = AddOptionalString(strings, serialization_company_phone.local_code());
+        number_ = AddOptionalString(strings, serialization_company_phone.number());
+        extension_ = AddOptionalString(strings, serialization_company_phone.extension());
+        description_ = AddOptionalString(strings, serialization_company_phone.description());
     }
 
     ::YellowPages::Phone CompanyPhone::SerializePhone() const {
         ::YellowPages::Phone serialization_phone;
-        serialization_phone.set_formatted(formatted_.has_value() ? *formatted_ : "");
+        serialization_phone.set_formatted(ToString(formatted_));
         serialization_phone.set_type(type_);
-        serialization_phone.set_country_code(country_code_.has_value() ? *country_code_ : "");
-        serialization_phone.set_local_code(local_code_.has_value() ? *local_code_ : "");
-        serialization_phone.set_number(number_.has_value() ? *number_ : "");
-        serialization_phone.set_extension(extension_.has_value() ? *extension_ : "");
-        serialization_phone.set_description(description_.has_value() ? *description_ : "");
+        serialization_phone.set_country_code(ToString(country_code_));
+        serialization_phone.set_local_code(ToString(local_code_));
+        serialization_phone.set_number(ToString(number_));
+        serialization_phone.set_extension(ToString(extension_));
+        serialization_phone.set_description(ToString(description_));
         return serialization_phone;
     }
 
+    std::vector<CompanyWorkingTime::Interval> CompanyWorkingTime::ReadIntervals(const Json::Dict &company_working_time_json) {
+        std::vector<Interval> intervals;
+        if (company_working_time_json.count("intervals")) {
+            intervals.reserve(company_working_time_json.at("intervals").AsArray().size());
+            for (const auto &interval_json_node : company_working_time_json.at("intervals").AsArray()) {
+                const Json::Dict &interval_json = interval_json_node.AsMap();
+                YellowPages::WorkingTimeInterval_Day day;
+                if (!YellowPages::WorkingTimeInterval_Day_Parse(interval_json.at("day").AsString(), &day)) {
+                    throw std::runtime_error("CompanyWorkingTime::ReadIntervals(const Json::Dict &company_working_time_json)");
+                }
+                intervals.push_back({day, interval_json.at("minutes_from").AsInt(), interval_json.at("minutes_to").AsInt()});
+            }
+        }
+        return intervals;
+    }
+
+    std::vector<CompanyWorkingTime::Interval> CompanyWorkingTime::ReadIntervals(const YellowPages::WorkingTime &serialization_company_working_time) {
+        std::vector<Interval> intervals;
+        intervals.reserve(serialization_company_working_time.intervals_size());
+        for (const auto &serialization_interval : serialization_company_working_time.intervals()) {
+            intervals.push_back({serialization_interval.day(), serialization_interval.minutes_from(), serialization_interval.minutes_to()});
+        }
+        return intervals;
+    }
 
-    Company::Company(const Json::Dict &company_json) {
-//        if (company_json.count("address")) {
-//            address_ = CompanyAddress(company_json.at("address").AsMap());
-//        }
+    std::vector<CompanyWorkingTime::WeekInterval> CompanyWorkingTime::BuildWeekIntervals(const std::vector<Interval> &intervals) {
+        std::vector<WeekInterval> week_intervals;
+        auto add_week_interval = [&week_intervals](int minutes_from, int minutes_to) {
+            if (minutes_to <= MINUTES_IN_WEEK) {
+                week_intervals.push_back({minutes_from, minutes_to});
+            } else {  // past Sunday midnight
+                week_intervals.push_back({minutes_from, MINUTES_IN_WEEK});
+                week_intervals.push_back({0, minutes_to - MINUTES_IN_WEEK});
+            }
+        };
+        for (const auto &interval : intervals) {
+            if (interval.minutes_from >= interval.minutes_to) { continue; }
 
-        names_.reserve(company_json.at("names").AsArray().size());
-        for (const auto &company_name_json : company_json.at("names").AsArray()) {
-            names_.emplace_back(company_name_json.AsMap());
-            if (!main_name_.has_value() && names_.back().is_main_name()) {
-                main_name_ = names_.back().get_name();
+            if (interval.day == YellowPages::WorkingTimeInterval_Day_EVERYDAY) {
+                for (int day_idx = 0; day_idx < 7; ++day_idx) {
+                    add_week_interval(day_idx * MINUTES_IN_DAY + interval.minutes_from, day_idx * MINUTES_IN_DAY + interval.minutes_to);
+                }
+            } else {
+                const int day_idx = static_cast<int>(interval.day) - static_cast<int>(YellowPages::WorkingTimeInterval_Day_MONDAY);
+                add_week_interval(day_idx * MINUTES_IN_DAY + interval.minutes_from, day_idx * MINUTES_IN_DAY + interval.minutes_to);
+            }
+        }
+
+        std::sort(week_intervals.begin(), week_intervals.end(), [](const WeekInterval &lhs, const WeekInterval &rhs) {
+            return lhs.minutes_from < rhs.minutes_from;
+        });
+        std::vector<WeekInterval> merged_intervals;
+        for (const WeekInterval &interval : week_intervals) {
+            if (!merged_intervals.empty() && interval.minutes_from <= merged_intervals.back().minutes_to) {
+                merged_intervals.back().minutes_to = std::max(merged_intervals.back().minutes_to, interval.minutes_to);
+            } else {
+                merged_intervals.push_back(interval);
             }
         }
+        return merged_intervals;
+    }
+
+    CompanyWorkingTime::CompanyWorkingTime(std::optional<std::string_view> formatted, ColumnRange<Interval> intervals, ColumnRange<WeekInterval> week_intervals)
+            : formatted_(formatted), intervals_(intervals), week_intervals_(week_intervals) {}
+
+    bool CompanyWorkingTime::is_always_open() const {
+        return intervals_.begin() == intervals_.end();
+    }
+
+    bool CompanyWorkingTime::is_open_at(int minute_of_week) const {
+        if (is_always_open()) { return true; }
+
+        auto it = std::upper_bound(week_intervals_.begin(), week_intervals_.end(), minute_of_week,
+                                   [](int minute, const WeekInterval &interval) {
+                                       return minute < interval.minutes_from;
+                                   });
+        return it != week_intervals_.begin() && minute_of_week < std::prev(it)->minutes_to;
+    }
+
+    ColumnRange<CompanyWorkingTime::WeekInterval> CompanyWorkingTime::get_week_intervals() const {
+        return week_intervals_;
+    }
+
+    YellowPages::WorkingTime CompanyWorkingTime::SerializeWorkingTime() const {
+        YellowPages::WorkingTime serialization_working_time;
+        serialization_working_time.set_formatted(ToString(formatted_));
+        for (const auto &interval : intervals_) {
+            YellowPages::WorkingTimeInterval &serialization_interval = *serialization_working_time.add_intervals();
+            serialization_interval.set_day(interval.day);
+            serialization_interval.set_minutes_from(interval.minutes_from);
+            serialization_interval.set_minutes_to(interval.minutes_to);
+        }
+        return serialization_working_time;
+    }
+
+
+    void CompaniesStore::AddCompany(const Json::Dict &company_json) {
+        if (company_json.count("address")) {
+            addresses_.emplace_back(CompanyAddress(company_json.at("address").AsMap(), strings_));
+        } else {
+            addresses_.emplace_back();
+        }
+
+        for (const auto &company_name_json : company_json.at("names").AsArray()) {
+            names_.rows.emplace_back(company_name_json.AsMap(), strings_);
+        }
 
         if (company_json.count("phones")) {
-            phones_.reserve(company_json.at("phones").AsArray().size());
             for (const auto &company_phone_json : company_json.at("phones").AsArray()) {
-                phones_.emplace_back(company_phone_json.AsMap());
+                phones_.rows.emplace_back(company_phone_json.AsMap(), strings_);
             }
         }
 
         if (company_json.count("urls")) {
-            urls_.reserve(company_json.at("urls").AsArray().size());
             for (const auto &company_url_json : company_json.at("urls").AsArray()) {
-                urls_.push_back(company_url_json.AsMap().at("value").AsString());
+                urls_.rows.push_back(strings_.Add(company_url_json.AsMap().at("value").AsString()));
             }
         }
 
-        rubrics_.reserve(company_json.at("rubrics").AsArray().size());
         for (const auto &company_rubric_json : company_json.at("rubrics").AsArray()) {
-            rubrics_.push_back(company_rubric_json.AsInt());
+            rubrics_.rows.push_back(company_rubric_json.AsInt());
+        }
+
+        std::vector<CompanyWorkingTime::Interval> working_time_intervals;
+        if (company_json.count("working_time")) {
+            const Json::Dict &working_time_json = company_json.at("working_time").AsMap();
+            working_time_formatted_.push_back(AddOptionalString(strings_, working_time_json, "formatted"));
+            working_time_intervals = CompanyWorkingTime::ReadIntervals(working_time_json);
+        } else {
+            working_time_formatted_.emplace_back();
+        }
+        const auto week_intervals = CompanyWorkingTime::BuildWeekIntervals(working_time_intervals);
+        working_time_intervals_.rows.insert(working_time_intervals_.rows.end(), working_time_intervals.begin(), working_time_intervals.end());
+        working_time_week_intervals_.rows.insert(working_time_week_intervals_.rows.end(), week_intervals.begin(), week_intervals.end());
+
+        if (company_json.count("nearby_stops")) {
+            for (const auto &company_nearby_stop_json : company_json.at("nearby_stops").AsArray()) {
+                nearby_stops_.rows.push_back({strings_.Add(company_nearby_stop_json.AsMap().at("name").AsString()),
+                                              static_cast<uint32_t>(company_nearby_stop_json.AsMap().at("meters").AsInt())});
+            }
         }
 
-//        if (company_json.count("nearby_stops")) {
-//            nearby_stops_.reserve(company_json.at("nearby_stops").AsArray().size());
-//            for (const auto &company_nearby_stop_json : company_json.at("nearby_stops").AsArray()) {
-//                nearby_stops_[company_nearby_stop_json.AsMap().at("name").AsString()] = company_nearby_stop_json.AsMap().at("meters").AsInt();
-//            }
-//        }
+        EndCompany();
     }
 
-    Company::Company(const ::YellowPages::Company &serialization_company) {
-        names_.reserve(serialization_company.names_size());
-        for (int name_idx = 0; name_idx < serialization_company.names_size(); ++name_idx) {
-            names_.emplace_back(serialization_company.names(name_idx));
-            if (!main_name_.has_value() && names_.back().is_main_name()) {
-                main_name_ = names_.back().get_name();
-            }
+    void CompaniesStore::AddCompany(const ::YellowPages::Company &serialization_company) {
+        if (serialization_company.has_address()) {
+            addresses_.emplace_back(CompanyAddress(serialization_company.address(), strings_));
+        } else {
+            addresses_.emplace_back();
         }
 
-        phones_.reserve(serialization_company.phones_size());
-        for (int phone_idx = 0; phone_idx < serialization_company.phones_size(); ++phone_idx) {
-            phones_.emplace_back(serialization_company.phones(phone_idx));
+        for (const auto &serialization_name : serialization_company.names()) {
+            names_.rows.emplace_back(serialization_name, strings_);
         }
 
-        urls_.reserve(serialization_company.urls_size());
-        for (int url_idx = 0; url_idx < serialization_company.urls_size(); ++url_idx) {
-            urls_.push_back(serialization_company.urls(url_idx).value());
+        for (const auto &serialization_phone : serialization_company.phones()) {
+            phones_.rows.emplace_back(serialization_phone, strings_);
         }
 
-        for (int rubric_idx = 0; rubric_idx < serialization_company.rubrics_size(); ++rubric_idx) {
-            rubrics_.push_back(serialization_company.rubrics(rubric_idx));
+        for (const auto &serialization_url : serialization_company.urls()) {
+            urls_.rows.push_back(strings_.Add(serialization_url.value()));
+        }
+
+        rubrics_.rows.insert(rubrics_.rows.end(), serialization_company.rubrics().begin(), serialization_company.rubrics().end());
+
+        working_time_formatted_.push_back(AddOptionalString(strings_, serialization_company.working_time().formatted()));
+        const auto working_time_intervals = CompanyWorkingTime::ReadIntervals(serialization_company.working_time());
+        const auto week_intervals = CompanyWorkingTime::BuildWeekIntervals(working_time_intervals);
+        working_time_intervals_.rows.insert(working_time_intervals_.rows.end(), working_time_intervals.begin(), working_time_intervals.end());
+        working_time_week_intervals_.rows.insert(working_time_week_intervals_.rows.end(), week_intervals.begin(), week_intervals.end());
+
+        for (const auto &serialization_nearby_stop : serialization_company.nearby_stops()) {
+            nearby_stops_.rows.push_back({strings_.Add(serialization_nearby_stop.name()), serialization_nearby_stop.meters()});
         }
+
+        EndCompany();
+    }
+
+    void CompaniesStore::EndCompany() {
+        const auto names = ColumnRange<CompanyName>{names_.rows.data() + names_.begins.back(), names_.rows.data() + names_.rows.size()};
+        const auto main_name_it = std::find_if(names.begin(), names.end(), [](const CompanyName &name) {
+            return name.is_main_name();
+        });
+        main_names_.push_back(main_name_it != names.end() ? main_name_it->get_name() : std::string_view());
+
+        names_.EndCompany();
+        phones_.EndCompany();
+        urls_.EndCompany();
+        rubrics_.EndCompany();
+        working_time_intervals_.EndCompany();
+        working_time_week_intervals_.EndCompany();
+        nearby_stops_.EndCompany();
+    }
+
+    void CompaniesStore::ShrinkToFit() {
+        main_names_.shrink_to_fit();
+        addresses_.shrink_to_fit();
+        names_.ShrinkToFit();
+        phones_.ShrinkToFit();
+        urls_.ShrinkToFit();
+        rubrics_.ShrinkToFit();
+        working_time_formatted_.shrink_to_fit();
+        working_time_intervals_.ShrinkToFit();
+        working_time_week_intervals_.ShrinkToFit();
+        nearby_stops_.ShrinkToFit();
+    }
+
+    size_t CompaniesStore::GetCompaniesCount() const {
+        return main_names_.size();
+    }
+
+    std::string_view CompaniesStore::GetMainName(CompanyId company_id) const {
+        return main_names_[company_id];
+    }
+
+    const std::optional<CompanyAddress> &CompaniesStore::GetAddress(CompanyId company_id) const {
+        return addresses_[company_id];
+    }
+
+    ColumnRange<CompanyName> CompaniesStore::GetNames(CompanyId company_id) const {
+        return names_.Get(company_id);
+    }
+
+    ColumnRange<CompanyPhone> CompaniesStore::GetPhones(CompanyId company_id) const {
+        return phones_.Get(company_id);
+    }
+
+    ColumnRange<std::string_view> CompaniesStore::GetUrls(CompanyId company_id) const {
+        return urls_.Get(company_id);
+    }
+
+    ColumnRange<uint64_t> CompaniesStore::GetRubrics(CompanyId company_id) const {
+        return rubrics_.Get(company_id);
+    }
+
+    CompanyWorkingTime CompaniesStore::GetWorkingTime(CompanyId company_id) const {
+        return CompanyWorkingTime(working_time_formatted_[company_id], working_time_intervals_.Get(company_id),
+                                  working_time_week_intervals_.Get(company_id));
+    }
+
+    ColumnRange<CompanyNearbyStop> CompaniesStore::GetNearbyStops(CompanyId company_id) const {
+        return nearby_stops_.Get(company_id);
+    }
+
+
+    Company::Company(const CompaniesStore &store, CompanyId company_id) : store_(&store), company_id_(company_id) {}
+
+    std::string_view Company::get_main_name() const {
+        return store_->GetMainName(company_id_);
+    }
+
+    const std::optional<CompanyAddress> &Company::get_company_address() const {
+        return store_->GetAddress(company_id_);
     }
 
-    const std::string &Company::get_main_name() const {
-        return *main_name_;
+    ColumnRange<CompanyName> Company::get_company_names() const {
+        return store_->GetNames(company_id_);
     }
 
-    const std::vector<CompanyName> &Company::get_company_names() const {
-        return names_;
+    ColumnRange<CompanyPhone> Company::get_company_phones() const {
+        return store_->GetPhones(company_id_);
     }
 
-    const std::vector<CompanyPhone> &Company::get_company_phones() const {
-        return phones_;
+    ColumnRange<std::string_view> Company::get_company_urls() const {
+        return store_->GetUrls(company_id_);
     }
 
-    const std::vector<std::string> &Company::get_company_urls() const {
-        return urls_;
+    ColumnRange<uint64_t> Company::get_company_rubrics() const {
+        return store_->GetRubrics(company_id_);
     }
 
-    const std::vector<uint64_t> &Company::get_company_rubrics() const {
-        return rubrics_;
+    CompanyWorkingTime Company::get_company_working_time() const {
+        return store_->GetWorkingTime(company_id_);
+    }
+
+    ColumnRange<CompanyNearbyStop> Company::get_company_nearby_stops() const {
+        return store_->GetNearbyStops(company_id_);
     }
 
     ::YellowPages::Company Company::SerializeCompany() const {
         ::YellowPages::Company serialization_company;
-        for (const auto &n : names_) {
+        if (const auto &address = get_company_address()) {
+            *serialization_company.mutable_address() = address->SerializeAddress();
+        }
+
+        for (const auto &n : get_company_names()) {
             *serialization_company.add_names() = n.SerializeName();
         }
 
-        for (const auto &ph : phones_) {
+        for (const auto &ph : get_company_phones()) {
             *serialization_company.add_phones() = ph.SerializePhone();
         }
 
-        for (const auto &url : urls_) {
+        for (const auto &url : get_company_urls()) {
             ::YellowPages::Url &serialization_url = *serialization_company.add_urls();
-            serialization_url.set_value(url);
+            serialization_url.set_value(std::string(url));
         }
 
-        for (auto rubric_id : rubrics_) {
+        for (auto rubric_id : get_company_rubrics()) {
             serialization_company.add_rubrics(rubric_id);
         }
 
+        *serialization_company.mutable_working_time() = get_company_working_time().SerializeWorkingTime();
+
+        for (const auto &nearby_stop : get_company_nearby_stops()) {
+            ::YellowPages::NearbyStop &serialization_nearby_stop = *serialization_company.add_nearby_stops();
+            serialization_nearby_stop.set_name(std::string(nearby_stop.name));
+            serialization_nearby_stop.set_meters(nearby_stop.meters);
+        }
+
         return serialization_company;
     }
 
@@ -225,10 +453,11 @@ namespace YellowPagesDatabase {
             }
         }
 
-        companies_.reserve(yellow_pages_json.at("companies").AsArray().size());
+        companies_store_ = std::make_unique<CompaniesStore>();
         for (const auto &company : yellow_pages_json.at("companies").AsArray()) {
-            companies_.emplace_back(company.AsMap());
+            companies_store_->AddCompany(company.AsMap());
         }
+        BuildCompanies();
     }
 
     YellowPagesDb::YellowPagesDb(const ::YellowPages::Database &serialization_yellow_pages) {
@@ -247,30 +476,75 @@ namespace YellowPagesDatabase {
             }
         }
 
-        companies_.reserve(serialization_yellow_pages.companies_size());
-        for (int company_idx = 0; company_idx < serialization_yellow_pages.companies_size(); ++company_idx) {
-            companies_.emplace_back(serialization_yellow_pages.companies(company_idx));
+        companies_store_ = std::make_unique<CompaniesStore>();
+        for (const auto &serialization_company : serialization_yellow_pages.companies()) {
+            companies_store_->AddCompany(serialization_company);
+        }
+        BuildCompanies();
+    }
+
+    void YellowPagesDb::BuildCompanies() {
+        companies_store_->ShrinkToFit();
+        companies_.reserve(companies_store_->GetCompaniesCount());
+        for (CompanyId company_id = 0; company_id < companies_store_->GetCompaniesCount(); ++company_id) {
+            companies_.emplace_back(*companies_store_, company_id);
         }
+        companies_index_ = CompaniesIndex(companies_);
     }
 
     const std::unordered_map<std::string, uint64_t> &YellowPagesDb::get_rubric_ids_dict() const {
         return rubric_ids_;
     }
 
-    std::vector<const YellowPagesDatabase::Company *> YellowPagesDb::SearchCompanies(const std::array<const YellowPagesSearch::CompanyConstraint *, 4> &companies_constraint_ptrs) const {
+    const std::vector<Company> &YellowPagesDb::get_companies() const {
+        return companies_;
+    }
+
+    std::vector<const YellowPagesDatabase::Company *> YellowPagesDb::SearchCompanies(const YellowPagesSearch::CompanyConstraints &companies_constraint_ptrs,
+                                                                                     YellowPagesSearch::SearchPlan *plan) const {
+        // Ids of the suitable companies are in the order of the database
+        const std::shared_ptr<const std::optional<CompanyIds>> suitable_ids = SearchCompanyIds(companies_constraint_ptrs, plan);
+
         std::vector<const YellowPagesDatabase::Company *> res;
-        for (const auto &company : companies_) {
-            bool is_company_suite = std::all_of(companies_constraint_ptrs.begin(), companies_constraint_ptrs.end(),
-                                                [&company](const YellowPagesSearch::CompanyConstraint *cur_consraint_ptr) {
-                                                    return cur_consraint_ptr->is_suite(company);
-                                                });
-            if (is_company_suite) {
+        if (!*suitable_ids) {
+            res.reserve(companies_.size());
+            for (const auto &company : companies_) {
                 res.push_back(&company);
             }
+            return res;
+        }
+        res.reserve((*suitable_ids)->size());
+        for (CompanyId company_id : **suitable_ids) {
+            res.push_back(&companies_[company_id]);
         }
         return res;
     }
 
+    std::shared_ptr<const std::optional<CompanyIds>> YellowPagesDb::SearchCompanyIds(const YellowPagesSearch::CompanyConstraints &companies_constraint_ptrs,
+                                                                                     YellowPagesSearch::SearchPlan *plan) const {
+        const YellowPagesSearch::SearchPlanner planner(companies_index_, companies_);
+        if (plan) {  // the plan is of an executed search
+            return std::make_shared<const std::optional<CompanyIds>>(planner.Search(companies_constraint_ptrs, plan));
+        }
+
+        std::string cache_key;
+        for (const auto *constraint_ptr : companies_constraint_ptrs) {
+            cache_key += constraint_ptr->get_name();
+            cache_key.push_back('\0');
+            constraint_ptr->append_cache_key(cache_key);
+        }
+        if (auto cached_ids = search_cache_->Get(cache_key)) {
+            return *cached_ids;
+        }
+        auto suitable_ids = std::make_shared<const std::optional<CompanyIds>>(planner.Search(companies_constraint_ptrs));
+        search_cache_->Put(std::move(cache_key), suitable_ids);
+        return suitable_ids;
+    }
+
+    LruCacheStats YellowPagesDb::GetSearchCacheStats() const {
+        return search_cache_->GetStats();
+    }
+
     ::YellowPages::Database YellowPagesDb::SerializeYellowPages() const {
         ::YellowPages::Database serialization_yellow_pages;
 
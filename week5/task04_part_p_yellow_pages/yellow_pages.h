@@ -1,14 +1,25 @@
 #pragma once
 
 #include <array>
+#include <memory>
+#include <optional>
+#include <string_view>
 
+#include "address.pb.h"
 #include "company.pb.h"
 #include "database.pb.h"
 #include "name.pb.h"
 #include "phone.pb.h"
+#include "working_time.pb.h"
 
 #include "json.h"
+#include "lru_cache.h"
+#include "sphere.h"
+#include "string_arena.h"
+#include "utils.h"
+#include "yellow_pages_index.h"
 #include "yellow_pages_search.h"
+#include "yellow_pages_search_plan.h"
 
 namespace YellowPagesSearch {
     class CompanyConstraint;
@@ -25,33 +36,38 @@ namespace YellowPagesSearch {
 
 namespace YellowPagesDatabase {
 
-    struct Coords {
-        double latitude_;
-        double longitude_;
-    };
+    // Consecutive rows of a column of CompaniesStore
+    template<typename T>
+    using ColumnRange = Range<const T *>;
+
+    // The views below point into the strings of a CompaniesStore and live as long as it does
 
     class CompanyAddress {
     public:
-        explicit CompanyAddress(const Json::Dict &company_address_json);
+        explicit CompanyAddress(const Json::Dict &company_address_json, StringArena &strings);
+
+        explicit CompanyAddress(const YellowPages::Address &serialization_company_address, StringArena &strings);
 
-//        explicit CompanyAddress(const YellowPages::Address &serialization_company_address);
+        const std::optional<Sphere::Point> &get_coords() const;
+
+        YellowPages::Address SerializeAddress() const;
 
     private:
-        std::optional<std::string> formatted_;
+        std::optional<std::string_view> formatted_;
 //        std::vector<CompanyAddressComponent> components_;
-        std::optional<Coords> coords_;
-        std::optional<std::string> comment_;
+        std::optional<Sphere::Point> coords_;
+        std::optional<std::string_view> comment_;
 
     };
 
     class CompanyName {
     public:
 
-        explicit CompanyName(const Json::Dict &company_name_json);
+        explicit CompanyName(const Json::Dict &company_name_json, StringArena &strings);
 
-        explicit CompanyName(const YellowPages::Name &serialization_company_name);
+        explicit CompanyName(const YellowPages::Name &serialization_company_name, StringArena &strings);
 
-        const std::string &get_name() const;
+        std::string_view get_name() const;
 
         bool is_main_name() const;
 
@@ -59,7 +75,7 @@ namespace YellowPagesDatabase {
 
 
     private:
-        std::string value_;
+        std::string_view value_;
         YellowPages::Name_Type type_;
     };
 
@@ -67,49 +83,158 @@ namespace YellowPagesDatabase {
 //        friend bool YellowPagesSearch::CompanyPhoneConstraint::OnePhoneConstraint::is_one_phone_suite(const CompanyPhone &phone_to_check) const;  // todo
 
     public:
-        explicit CompanyPhone(const Json::Dict &company_phone_json);
+        explicit CompanyPhone(const Json::Dict &company_phone_json, StringArena &strings);
 
-        explicit CompanyPhone(const YellowPages::Phone &serialization_company_phone);
+        explicit CompanyPhone(const YellowPages::Phone &serialization_company_phone, StringArena &strings);
 
         YellowPages::Phone SerializePhone() const;
 
     public:  // todo:
-        std::optional<std::string> formatted_;
+        std::optional<std::string_view> formatted_;
         YellowPages::Phone_Type type_;
-        std::optional<std::string> country_code_;
-        std::optional<std::string> local_code_;
-        std::optional<std::string> number_;
-        std::optional<std::string> extension_;
-        std::optional<std::string> description_;
+        std::optional<std::string_view> country_code_;
+        std::optional<std::string_view> local_code_;
+        std::optional<std::string_view> number_;
+        std::optional<std::string_view> extension_;
+        std::optional<std::string_view> description_;
+    };
+
+    // Working time by days of week; a company without intervals works round the clock
+    class CompanyWorkingTime {
+    public:
+        static constexpr int MINUTES_IN_DAY = 24 * 60;
+        static constexpr int MINUTES_IN_WEEK = 7 * MINUTES_IN_DAY;
+
+        struct Interval {
+            YellowPages::WorkingTimeInterval_Day day;
+            int minutes_from;
+            int minutes_to;
+        };
+
+        // [minutes_from, minutes_to) since Monday 00:00
+        struct WeekInterval {
+            int minutes_from;
+            int minutes_to;
+        };
+
+        static std::vector<Interval> ReadIntervals(const Json::Dict &company_working_time_json);
+
+        static std::vector<Interval> ReadIntervals(const YellowPages::WorkingTime &serialization_company_working_time);
+
+        // Sorted, without overlaps
+        static std::vector<WeekInterval> BuildWeekIntervals(const std::vector<Interval> &intervals);
+
+        CompanyWorkingTime(std::optional<std::string_view> formatted, ColumnRange<Interval> intervals, ColumnRange<WeekInterval> week_intervals);
+
+        bool is_always_open() const;
+
+        bool is_open_at(int minute_of_week) const;
+
+        ColumnRange<WeekInterval> get_week_intervals() const;
+
+        YellowPages::WorkingTime SerializeWorkingTime() const;
+
+    private:
+        std::optional<std::string_view> formatted_;
+        ColumnRange<Interval> intervals_;
+        ColumnRange<WeekInterval> week_intervals_;
+    };
+
+    struct CompanyNearbyStop {
+        std::string_view name;
+        uint32_t meters;
+    };
+
+    // Fields of all the companies in columns: the rows of a company are consecutive in every column,
+    // and the strings are in one arena, so loading takes a few large allocations instead of several per field
+    class CompaniesStore {
+    public:
+        void AddCompany(const Json::Dict &company_json);
+
+        void AddCompany(const YellowPages::Company &serialization_company);
+
+        // After the last company is added
+        void ShrinkToFit();
+
+        size_t GetCompaniesCount() const;
+
+        std::string_view GetMainName(CompanyId company_id) const;
+
+        const std::optional<CompanyAddress> &GetAddress(CompanyId company_id) const;
+
+        ColumnRange<CompanyName> GetNames(CompanyId company_id) const;
+
+        ColumnRange<CompanyPhone> GetPhones(CompanyId company_id) const;
+
+        ColumnRange<std::string_view> GetUrls(CompanyId company_id) const;
+
+        ColumnRange<uint64_t> GetRubrics(CompanyId company_id) const;
+
+        CompanyWorkingTime GetWorkingTime(CompanyId company_id) const;
+
+        ColumnRange<CompanyNearbyStop> GetNearbyStops(CompanyId company_id) const;
+
+    private:
+        // Rows of company i are [begins[i], begins[i + 1])
+        template<typename T>
+        struct Column {
+            std::vector<T> rows;
+            std::vector<uint32_t> begins{0};
+
+            void EndCompany() { begins.push_back(rows.size()); }
+
+            ColumnRange<T> Get(CompanyId company_id) const {
+                return {rows.data() + begins[company_id], rows.data() + begins[company_id + 1]};
+            }
+
+            void ShrinkToFit() {
+                rows.shrink_to_fit();
+                begins.shrink_to_fit();
+            }
+        };
+
+        void EndCompany();
+
+        StringArena strings_;
+
+        std::vector<std::string_view> main_names_;  // empty if the company has no main name
+        std::vector<std::optional<CompanyAddress>> addresses_;
+        Column<CompanyName> names_;
+        Column<CompanyPhone> phones_;
+        Column<std::string_view> urls_;
+        Column<uint64_t> rubrics_;
+        std::vector<std::optional<std::string_view>> working_time_formatted_;
+        Column<CompanyWorkingTime::Interval> working_time_intervals_;
+        Column<CompanyWorkingTime::WeekInterval> working_time_week_intervals_;
+        Column<CompanyNearbyStop> nearby_stops_;
     };
 
+    // Company of a CompaniesStore
     class Company {
     public:
-        explicit Company(const Json::Dict &company_json);
+        Company(const CompaniesStore &store, CompanyId company_id);
+
+        std::string_view get_main_name() const;
 
-        explicit Company(const YellowPages::Company &serialization_company);
+        const std::optional<CompanyAddress> &get_company_address() const;
 
-        const std::string& get_main_name() const;
+        ColumnRange<CompanyName> get_company_names() const;
 
-        const std::vector<CompanyName> &get_company_names() const;
+        ColumnRange<CompanyPhone> get_company_phones() const;
 
-        const std::vector<CompanyPhone> &get_company_phones() const;
+        ColumnRange<std::string_view> get_company_urls() const;
 
-        const std::vector<std::string> &get_company_urls() const;
+        ColumnRange<uint64_t> get_company_rubrics() const;
 
-        const std::vector<uint64_t> &get_company_rubrics() const;
+        CompanyWorkingTime get_company_working_time() const;
+
+        ColumnRange<CompanyNearbyStop> get_company_nearby_stops() const;
 
         ::YellowPages::Company SerializeCompany() const;
 
     private:
-//        std::optional<CompanyAddress> address_;
-        std::vector<CompanyName> names_;
-        std::optional<std::string> main_name_;
-        std::vector<CompanyPhone> phones_;
-        std::vector<std::string> urls_;  // todo: std::unordered_set
-        std::vector<uint64_t> rubrics_;  // todo: std::unordered_set
-        // CompanyWorkingTime working_time_;
-//        std::unordered_map<std::string, uint32_t> nearby_stops_;
+        const CompaniesStore *store_;
+        CompanyId company_id_;
     };
 
     class YellowPagesDb {
@@ -122,16 +247,38 @@ namespace YellowPagesDatabase {
 
         const std::unordered_map<std::string, uint64_t> &get_rubric_ids_dict() const;
 
-        std::vector<const YellowPagesDatabase::Company *> SearchCompanies(const ::std::array<const YellowPagesSearch::CompanyConstraint *, 4> &companies_constraint_ptrs) const;
+        // Company ids are positions in it
+        const std::vector<Company> &get_companies() const;
+
+        // Results of the searches without a plan are cached by the canonical values of the constraints
+        std::vector<const YellowPagesDatabase::Company *> SearchCompanies(const YellowPagesSearch::CompanyConstraints &companies_constraint_ptrs,
+                                                                          YellowPagesSearch::SearchPlan *plan = nullptr) const;
+
+        LruCacheStats GetSearchCacheStats() const;
 
         ::YellowPages::Database SerializeYellowPages() const;
 
     private:
+        // Ids of the suitable companies, nullopt for all of them
+        using SearchCache = LruCache<std::string, std::shared_ptr<const std::optional<CompanyIds>>>;
+
+        static constexpr size_t SEARCH_CACHE_CAPACITY = 256;
+
+        void BuildCompanies();
+
+        // Shared with the search cache
+        std::shared_ptr<const std::optional<CompanyIds>> SearchCompanyIds(const YellowPagesSearch::CompanyConstraints &companies_constraint_ptrs,
+                                                                          YellowPagesSearch::SearchPlan *plan) const;
+
         std::unordered_map<std::string, uint64_t> rubric_ids_;
         std::unordered_map<uint64_t, std::string> main_rubric_names_;
         std::unordered_map<uint64_t, std::vector<std::string>> keyword_rubric_names_;
 
+        std::unique_ptr<CompaniesStore> companies_store_;  // not to move with the database, as companies_ point to it
         std::vector<Company> companies_;
+        CompaniesIndex companies_index_;
+
+        std::unique_ptr<SearchCache> search_cache_ = std::make_unique<SearchCache>(SEARCH_CACHE_CAPACITY);
     };
 
 
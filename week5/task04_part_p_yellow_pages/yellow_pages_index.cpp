@@ -0,0 +1,332 @@
+#include "yellow_pages_index.h"
+
+#include <algorithm>
+#include <bitset>
+#include <iterator>
+
+#include "yellow_pages.h"
+
+
+namespace YellowPagesDatabase {
+    namespace {
+        // Companies are added in increasing id order, so a posting list stays sorted by appending
+        void AddToPostingList(CompanyIds &posting_list, CompanyId company_id) {
+            if (posting_list.empty() || posting_list.back() != company_id) {
+                posting_list.push_back(company_id);
+            }
+        }
+
+        template<typename Key>
+        const CompanyIds &FindPostingList(const std::unordered_map<Key, CompanyIds> &posting_lists, const Key &key, const CompanyIds &empty_ids) {
+            auto it = posting_lists.find(key);
+            return it == posting_lists.end() ? empty_ids : it->second;
+        }
+
+        template<typename Key>
+        CompaniesBitmap &GetOrAddBitmap(std::unordered_map<Key, CompaniesBitmap> &bitmaps, const Key &key, size_t companies_count) {
+            return bitmaps.try_emplace(key, companies_count).first->second;
+        }
+
+        template<typename Key>
+        const CompaniesBitmap &FindBitmap(const std::unordered_map<Key, CompaniesBitmap> &bitmaps, const Key &key, const CompaniesBitmap &empty_bitmap) {
+            auto it = bitmaps.find(key);
+            return it == bitmaps.end() ? empty_bitmap : it->second;
+        }
+
+        void AppendToPhoneKey(std::string &packed_key, std::optional<std::string_view> field) {
+            if (!field) {
+                packed_key.push_back('\0');
+                return;
+            }
+            packed_key.push_back('\1');
+            const auto field_size = static_cast<uint32_t>(field->size());
+            packed_key.append(reinterpret_cast<const char *>(&field_size), sizeof(field_size));
+            packed_key.append(*field);
+        }
+
+        bool IsValidPhoneKeyFields(uint8_t key_fields) {
+            return !(key_fields & PhoneKeyFields::COUNTRY_CODE) || (key_fields & PhoneKeyFields::LOCAL_CODE);
+        }
+
+        // Node of the interval tree of the working intervals in CompaniesIndex, of the minutes [first, last)
+        struct MinutesNode {
+            size_t index;  // in the heap order, the root is 1
+            int first;
+            int last;
+
+            int GetMiddle() const {
+                return first + (last - first) / 2;
+            }
+
+            MinutesNode GetBefore() const {
+                return {2 * index, first, GetMiddle()};
+            }
+
+            MinutesNode GetAfter() const {
+                return {2 * index + 1, GetMiddle() + 1, last};
+            }
+        };
+
+        const MinutesNode WEEK_NODE{1, 0, CompanyWorkingTime::MINUTES_IN_WEEK};
+
+        // The node of a working interval, the first one whose middle minute it contains
+        size_t FindWorkingIntervalNode(int minutes_from, int minutes_to) {
+            MinutesNode node = WEEK_NODE;
+            while (true) {
+                if (minutes_to <= node.GetMiddle()) {
+                    node = node.GetBefore();
+                } else if (minutes_from > node.GetMiddle()) {
+                    node = node.GetAfter();
+                } else {
+                    return node.index;
+                }
+            }
+        }
+
+        // Word loops without branches, so that the compiler vectorizes them
+        size_t PopCount(uint64_t word) {
+            return std::bitset<64>(word).count();
+        }
+    }
+
+    CompaniesBitmap::CompaniesBitmap(size_t companies_count) : words_(GetWordsCount(companies_count), 0) {}
+
+    size_t CompaniesBitmap::GetWordsCount(size_t companies_count) {
+        return (companies_count + WORD_BITS - 1) / WORD_BITS;
+    }
+
+    void CompaniesBitmap::Set(CompanyId company_id) {
+        words_[company_id / WORD_BITS] |= uint64_t(1) << (company_id % WORD_BITS);
+    }
+
+    bool CompaniesBitmap::Test(CompanyId company_id) const {
+        return company_id / WORD_BITS < words_.size() && (words_[company_id / WORD_BITS] >> (company_id % WORD_BITS) & 1);
+    }
+
+    CompaniesBitmap &CompaniesBitmap::operator|=(const CompaniesBitmap &other) {
+        for (size_t word_idx = 0; word_idx < words_.size(); ++word_idx) {
+            words_[word_idx] |= other.words_[word_idx];
+        }
+        return *this;
+    }
+
+    CompaniesBitmap &CompaniesBitmap::operator&=(const CompaniesBitmap &other) {
+        for (size_t word_idx = 0; word_idx < words_.size(); ++word_idx) {
+            words_[word_idx] &= other.words_[word_idx];
+        }
+        return *this;
+    }
+
+    size_t CompaniesBitmap::Count() const {
+        size_t count = 0;
+        for (uint64_t word : words_) {
+            count += PopCount(word);
+        }
+        return count;
+    }
+
+    CompanyIds CompaniesBitmap::ToIds() const {
+        CompanyIds ids;
+        ids.reserve(Count());
+        for (size_t word_idx = 0; word_idx < words_.size(); ++word_idx) {
+            for (uint64_t word = words_[word_idx]; word; word &= word - 1) {
+                const uint64_t lowest_bit = word & (~word + 1);
+                ids.push_back(static_cast<CompanyId>(word_idx * WORD_BITS + PopCount(lowest_bit - 1)));
+            }
+        }
+        return ids;
+    }
+
+    std::string PackPhoneKey(uint8_t key_fields, YellowPages::Phone_Type type, std::optional<std::string_view> country_code,
+                             std::optional<std::string_view> local_code, std::optional<std::string_view> number,
+                             std::optional<std::string_view> extension) {
+        std::string packed_key;
+        if (key_fields & PhoneKeyFields::TYPE) {
+            packed_key.push_back(static_cast<char>(type));
+        }
+        if (key_fields & PhoneKeyFields::COUNTRY_CODE) {
+            AppendToPhoneKey(packed_key, country_code);
+        }
+        if (key_fields & PhoneKeyFields::LOCAL_CODE) {
+            AppendToPhoneKey(packed_key, local_code);
+        }
+        if (key_fields & PhoneKeyFields::EXTENSION) {
+            AppendToPhoneKey(packed_key, extension);
+        }
+        AppendToPhoneKey(packed_key, number);
+        return packed_key;
+    }
+
+    const CompanyIds CompaniesIndex::EMPTY_IDS;
+
+    CompaniesIndex::CompaniesIndex(const std::vector<Company> &companies) : companies_count_(companies.size()), empty_bitmap_(companies.size()) {
+        struct NodeWorkingInterval {
+            size_t node_index;
+            CompanyWorkingTime::WeekInterval week_interval;
+            CompanyId company_id;
+        };
+        std::vector<NodeWorkingInterval> working_intervals;
+        std::vector<int> open_count_changes(CompanyWorkingTime::MINUTES_IN_WEEK + 1, 0);
+
+        for (CompanyId company_id = 0; company_id < companies.size(); ++company_id) {
+            const Company &company = companies[company_id];
+            for (const auto &company_name : company.get_company_names()) {
+                AddToPostingList(ids_by_name_[std::string(company_name.get_name())], company_id);
+            }
+            for (const auto &company_url : company.get_company_urls()) {
+                AddToPostingList(ids_by_url_[std::string(company_url)], company_id);
+            }
+            for (uint64_t rubric_id : company.get_company_rubrics()) {
+                AddToPostingList(ids_by_rubric_[rubric_id], company_id);
+            }
+            for (const auto &company_phone : company.get_company_phones()) {
+                // One table per combination of the fields a query may omit, so that any phone constraint is a single lookup
+                for (uint8_t key_fields = 0; key_fields < PhoneKeyFields::COMBINATIONS_COUNT; ++key_fields) {
+                    if (!IsValidPhoneKeyFields(key_fields)) { continue; }
+                    const std::string packed_key = PackPhoneKey(key_fields, company_phone.type_, company_phone.country_code_,
+                                                                company_phone.local_code_, company_phone.number_, company_phone.extension_);
+                    AddToPostingList(ids_by_phone_key_[key_fields][packed_key], company_id);
+                }
+            }
+
+            const CompanyWorkingTime &working_time = company.get_company_working_time();
+            if (working_time.is_always_open()) {
+                always_open_ids_.push_back(company_id);
+                continue;
+            }
+            for (const auto &week_interval : working_time.get_week_intervals()) {
+                const size_t node_index = FindWorkingIntervalNode(week_interval.minutes_from, week_interval.minutes_to);
+                working_intervals.push_back({node_index, week_interval, company_id});
+                if (working_intervals_offsets_by_node_.size() < node_index + 2) {
+                    working_intervals_offsets_by_node_.resize(node_index + 2, 0);
+                }
+                ++working_intervals_offsets_by_node_[node_index + 1];
+                ++open_count_changes[week_interval.minutes_from];
+                --open_count_changes[week_interval.minutes_to];
+            }
+        }
+
+        open_counts_by_minute_.resize(CompanyWorkingTime::MINUTES_IN_WEEK);
+        int open_count = 0;
+        for (int minute_of_week = 0; minute_of_week < CompanyWorkingTime::MINUTES_IN_WEEK; ++minute_of_week) {
+            open_count += open_count_changes[minute_of_week];
+            open_counts_by_minute_[minute_of_week] = open_count;
+        }
+
+        // Counting sort of the intervals by their nodes
+        for (size_t node_index = 1; node_index < working_intervals_offsets_by_node_.size(); ++node_index) {
+            working_intervals_offsets_by_node_[node_index] += working_intervals_offsets_by_node_[node_index - 1];
+        }
+        working_intervals_by_from_.resize(working_intervals.size());
+        working_intervals_by_to_.resize(working_intervals.size());
+        std::vector<size_t> next_positions = working_intervals_offsets_by_node_;
+        for (const auto &[node_index, week_interval, company_id] : working_intervals) {
+            const size_t position = next_positions[node_index]++;
+            working_intervals_by_from_[position] = {week_interval.minutes_from, company_id};
+            working_intervals_by_to_[position] = {week_interval.minutes_to, company_id};
+        }
+        for (size_t node_index = 0; node_index + 1 < working_intervals_offsets_by_node_.size(); ++node_index) {
+            const size_t begin = working_intervals_offsets_by_node_[node_index], end = working_intervals_offsets_by_node_[node_index + 1];
+            std::sort(working_intervals_by_from_.begin() + begin, working_intervals_by_from_.begin() + end,
+                      [](const WorkingIntervalBound &lhs, const WorkingIntervalBound &rhs) { return lhs.minutes < rhs.minutes; });
+            std::sort(working_intervals_by_to_.begin() + begin, working_intervals_by_to_.begin() + end,
+                      [](const WorkingIntervalBound &lhs, const WorkingIntervalBound &rhs) { return lhs.minutes > rhs.minutes; });
+        }
+
+        for (const auto &[rubric_id, rubric_ids] : ids_by_rubric_) {
+            CompaniesBitmap &rubric_bitmap = GetOrAddBitmap(bitmap_by_rubric_, rubric_id, companies_count_);
+            for (CompanyId company_id : rubric_ids) {
+                rubric_bitmap.Set(company_id);
+            }
+        }
+    }
+
+    size_t CompaniesIndex::GetCompaniesCount() const {
+        return companies_count_;
+    }
+
+    const CompanyIds &CompaniesIndex::FindByName(const std::string &name) const {
+        return FindPostingList(ids_by_name_, name, EMPTY_IDS);
+    }
+
+    const CompanyIds &CompaniesIndex::FindByUrl(const std::string &url) const {
+        return FindPostingList(ids_by_url_, url, EMPTY_IDS);
+    }
+
+    const CompanyIds &CompaniesIndex::FindByRubric(uint64_t rubric_id) const {
+        return FindPostingList(ids_by_rubric_, rubric_id, EMPTY_IDS);
+    }
+
+    const CompanyIds &CompaniesIndex::FindByPhoneKey(uint8_t key_fields, const std::string &packed_key) const {
+        return FindPostingList(ids_by_phone_key_[key_fields], packed_key, EMPTY_IDS);
+    }
+
+    const CompaniesBitmap &CompaniesIndex::GetRubricBitmap(uint64_t rubric_id) const {
+        return FindBitmap(bitmap_by_rubric_, rubric_id, empty_bitmap_);
+    }
+
+    CompanyIds CompaniesIndex::FindOpenAt(int minute_of_week) const {
+        CompanyIds open_ids = always_open_ids_;
+        open_ids.reserve(CountOpenAt(minute_of_week));
+        // The nodes of the minute down from the root, while there are nodes with intervals
+        for (MinutesNode node = WEEK_NODE; node.index + 1 < working_intervals_offsets_by_node_.size();) {
+            const size_t begin = working_intervals_offsets_by_node_[node.index], end = working_intervals_offsets_by_node_[node.index + 1];
+            if (minute_of_week < node.GetMiddle()) {  // the intervals end after it, the ones starting by it contain it
+                for (size_t position = begin; position < end && working_intervals_by_from_[position].minutes <= minute_of_week; ++position) {
+                    open_ids.push_back(working_intervals_by_from_[position].company_id);
+                }
+                node = node.GetBefore();
+            } else {  // the intervals start by it, the ones ending after it contain it
+                for (size_t position = begin; position < end && working_intervals_by_to_[position].minutes > minute_of_week; ++position) {
+                    open_ids.push_back(working_intervals_by_to_[position].company_id);
+                }
+                if (minute_of_week == node.GetMiddle()) { break; }
+                node = node.GetAfter();
+            }
+        }
+        // The intervals of a company are merged, so it is found once
+        std::sort(open_ids.begin(), open_ids.end());
+        return open_ids;
+    }
+
+    size_t CompaniesIndex::CountOpenAt(int minute_of_week) const {
+        return always_open_ids_.size() + open_counts_by_minute_[minute_of_week];
+    }
+
+    CompanyIds UniteCompanyIds(const std::vector<const CompanyIds *> &ids_lists) {
+        if (ids_lists.size() == 1) {
+            return *ids_lists.front();
+        }
+        CompanyIds united;
+        for (const CompanyIds *ids : ids_lists) {
+            united.insert(united.end(), ids->begin(), ids->end());
+        }
+        std::sort(united.begin(), united.end());
+        united.erase(std::unique(united.begin(), united.end()), united.end());
+        return united;
+    }
+
+    CompanyIds IntersectCompanyIds(const CompanyIds &lhs, const CompanyIds &rhs) {
+        // Galloping: every id of the smaller list is looked up by an exponential search from the previous match,
+        // so a short candidate list against a long posting list costs O(small * log(large / small))
+        const CompanyIds &smaller = lhs.size() <= rhs.size() ? lhs : rhs;
+        const CompanyIds &larger = lhs.size() <= rhs.size() ? rhs : lhs;
+
+        CompanyIds intersection;
+        auto larger_it = larger.begin();
+        for (CompanyId company_id : smaller) {
+            auto lower = larger_it, upper = larger_it;
+            for (ptrdiff_t step = 1; upper != larger.end() && *upper < company_id; step *= 2) {
+                lower = std::next(upper);
+                upper = larger.end() - upper > step ? upper + step : larger.end();
+            }
+            larger_it = std::lower_bound(lower, upper, company_id);
+            if (larger_it == larger.end()) { break; }
+            if (*larger_it == company_id) {
+                intersection.push_back(company_id);
+                ++larger_it;
+            }
+        }
+        return intersection;
+    }
+}
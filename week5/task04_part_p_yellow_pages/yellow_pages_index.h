@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "phone.pb.h"
+
+
+namespace YellowPagesDatabase {
+    class Company;
+
+    using CompanyId = uint32_t;  // position of the company in the database
+    using CompanyIds = std::vector<CompanyId>;  // sorted, without duplicates
+
+    // Set of company ids as one bit per company of the database, for set operations over dense posting lists
+    class CompaniesBitmap {
+    public:
+        CompaniesBitmap() = default;
+
+        explicit CompaniesBitmap(size_t companies_count);
+
+        // Of a bitmap of the companies, what an operation over the whole bitmap costs
+        static size_t GetWordsCount(size_t companies_count);
+
+        void Set(CompanyId company_id);
+
+        bool Test(CompanyId company_id) const;
+
+        // Both bitmaps are of the same database
+        CompaniesBitmap &operator|=(const CompaniesBitmap &other);
+
+        CompaniesBitmap &operator&=(const CompaniesBitmap &other);
+
+        size_t Count() const;
+
+        CompanyIds ToIds() const;
+
+    private:
+        static constexpr size_t WORD_BITS = 64;
+
+        std::vector<uint64_t> words_;
+    };
+
+    // Phone fields compared by a phone constraint besides the number, that is always compared
+    struct PhoneKeyFields {
+        static constexpr uint8_t TYPE = 1 << 0;
+        static constexpr uint8_t COUNTRY_CODE = 1 << 1;  // always together with LOCAL_CODE
+        static constexpr uint8_t LOCAL_CODE = 1 << 2;
+        static constexpr uint8_t EXTENSION = 1 << 3;
+
+        static constexpr size_t COMBINATIONS_COUNT = 1 << 4;
+    };
+
+    // Canonical key of the phone fields selected by key_fields and of the number, absent fields are distinct from any value
+    std::string PackPhoneKey(uint8_t key_fields, YellowPages::Phone_Type type, std::optional<std::string_view> country_code,
+                             std::optional<std::string_view> local_code, std::optional<std::string_view> number,
+                             std::optional<std::string_view> extension);
+
+    // Posting lists of the companies by the values of their searchable fields, built once the companies are loaded
+    class CompaniesIndex {
+    public:
+        CompaniesIndex() = default;
+
+        explicit CompaniesIndex(const std::vector<Company> &companies);
+
+        size_t GetCompaniesCount() const;
+
+        const CompanyIds &FindByName(const std::string &name) const;
+
+        const CompanyIds &FindByUrl(const std::string &url) const;
+
+        const CompanyIds &FindByRubric(uint64_t rubric_id) const;
+
+        // Companies having a phone with this PackPhoneKey of the key_fields
+        const CompanyIds &FindByPhoneKey(uint8_t key_fields, const std::string &packed_key) const;
+
+        const CompaniesBitmap &GetRubricBitmap(uint64_t rubric_id) const;
+
+        // Companies working at the minute since Monday 00:00
+        CompanyIds FindOpenAt(int minute_of_week) const;
+
+        size_t CountOpenAt(int minute_of_week) const;
+
+    private:
+        static const CompanyIds EMPTY_IDS;
+
+        size_t companies_count_ = 0;
+        std::unordered_map<std::string, CompanyIds> ids_by_name_;
+        std::unordered_map<std::string, CompanyIds> ids_by_url_;
+        std::unordered_map<uint64_t, CompanyIds> ids_by_rubric_;
+        std::array<std::unordered_map<std::string, CompanyIds>, PhoneKeyFields::COMBINATIONS_COUNT> ids_by_phone_key_;
+
+        struct WorkingIntervalBound {
+            int minutes;  // minutes_from in working_intervals_by_from_, minutes_to in working_intervals_by_to_
+            CompanyId company_id;
+        };
+
+        // Working intervals of the companies not always open, in an interval tree over the minutes of the week. A node
+        // keeps the intervals containing its middle minute and passes the others to its children, those of the minutes
+        // before and after the middle one. The intervals of a node are sorted by their starts and by their ends descending,
+        // so the ones containing a minute are a prefix of one of the orders. Each interval is kept once, by its node in
+        // the heap order of the tree
+        std::vector<size_t> working_intervals_offsets_by_node_;
+        std::vector<WorkingIntervalBound> working_intervals_by_from_;
+        std::vector<WorkingIntervalBound> working_intervals_by_to_;
+        std::vector<uint32_t> open_counts_by_minute_;  // of the companies not always open
+        CompanyIds always_open_ids_;
+
+        CompaniesBitmap empty_bitmap_;
+        std::unordered_map<uint64_t, CompaniesBitmap> bitmap_by_rubric_;
+    };
+
+    CompanyIds UniteCompanyIds(const std::vector<const CompanyIds *> &ids_lists);
+
+    CompanyIds IntersectCompanyIds(const CompanyIds &lhs, const CompanyIds &rhs);
+}
@@ -1,6 +1,30 @@
 #include "yellow_pages_search.h"
 
+#include <algorithm>
+
 namespace YellowPagesSearch {
+    namespace {
+        template<typename Values, typename FindIds>
+        size_t EstimateUnitedCount(const Values &values, const YellowPagesDatabase::CompaniesIndex &index, FindIds find_ids) {
+            size_t count = 0;
+            for (const auto &value : values) {
+                count += find_ids(value).size();
+            }
+            return std::min(count, index.GetCompaniesCount());
+        }
+
+        void AppendToCacheKey(std::string &key, std::string_view value) {
+            const auto value_size = static_cast<uint32_t>(value.size());
+            key.append(reinterpret_cast<const char *>(&value_size), sizeof(value_size));
+            key.append(value);
+        }
+
+        template<typename Number>
+        void AppendNumberToCacheKey(std::string &key, Number value) {
+            key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+    }
+
     CompanyNameConstraint::CompanyNameConstraint(const std::vector<Json::Node> &names_json) {
         for (const auto &name_json : names_json) {
             names_.insert(name_json.AsString());
@@ -18,6 +42,46 @@ namespace YellowPagesSearch {
 
     }
 
+    std::optional<YellowPagesDatabase::CompaniesBitmap> CompanyConstraint::find_suitable_bitmap(const YellowPagesDatabase::CompaniesIndex &) const {
+        return std::nullopt;
+    }
+
+    std::optional<size_t> CompanyConstraint::estimate_bitmap_words(const YellowPagesDatabase::CompaniesIndex &) const {
+        return std::nullopt;
+    }
+
+    const std::string &CompanyNameConstraint::get_name() const {
+        static const std::string name = "names";
+        return name;
+    }
+
+    size_t CompanyNameConstraint::estimate_count(const YellowPagesDatabase::CompaniesIndex &index) const {
+        return EstimateUnitedCount(names_, index, [&index](const std::string &name) -> const YellowPagesDatabase::CompanyIds & {
+            return index.FindByName(name);
+        });
+    }
+
+    void CompanyNameConstraint::append_cache_key(std::string &key) const {
+        AppendNumberToCacheKey(key, names_.size());
+        for (const auto &name : names_) {  // sorted
+            AppendToCacheKey(key, name);
+        }
+    }
+
+    bool CompanyNameConstraint::is_empty() const {
+        return names_.empty();
+    }
+
+    YellowPagesDatabase::CompanyIds CompanyNameConstraint::find_suitable(const YellowPagesDatabase::CompaniesIndex &index,
+                                                                         const std::vector<YellowPagesDatabase::Company> &) const {
+        std::vector<const YellowPagesDatabase::CompanyIds *> ids_lists;
+        ids_lists.reserve(names_.size());
+        for (const auto &name : names_) {
+            ids_lists.push_back(&index.FindByName(name));
+        }
+        return YellowPagesDatabase::UniteCompanyIds(ids_lists);
+    }
+
     CompanyPhoneConstraint::OnePhoneConstraint::OnePhoneConstraint(const Json::Node &one_phone_json_node) {
         const Json::Dict &one_phone_json = one_phone_json_node.AsMap();
         if (one_phone_json.count("type")) {
@@ -39,6 +103,22 @@ namespace YellowPagesSearch {
         if (one_phone_json.count("extension") && !one_phone_json.at("extension").AsString().empty()) {  // пустой == отсутствует
             extension_ = one_phone_json.at("extension").AsString();
         }
+
+        // The same fields is_one_phone_suite compares
+        if (type_) {
+            key_fields_ |= YellowPagesDatabase::PhoneKeyFields::TYPE;
+        }
+        if (country_code_) {
+            key_fields_ |= YellowPagesDatabase::PhoneKeyFields::COUNTRY_CODE | YellowPagesDatabase::PhoneKeyFields::LOCAL_CODE;
+        }
+        if (local_code_) {
+            key_fields_ |= YellowPagesDatabase::PhoneKeyFields::LOCAL_CODE;
+        }
+        if (extension_) {
+            key_fields_ |= YellowPagesDatabase::PhoneKeyFields::EXTENSION;
+        }
+        packed_key_ = YellowPagesDatabase::PackPhoneKey(key_fields_, type_.value_or(::YellowPages::Phone_Type::Phone_Type_PHONE),
+                                                        country_code_, local_code_, number_, extension_);
     }
 
     bool CompanyPhoneConstraint::OnePhoneConstraint::is_one_phone_suite(const YellowPagesDatabase::CompanyPhone &phone_to_check) const {
@@ -74,6 +154,14 @@ namespace YellowPagesSearch {
         throw std::runtime_error("CompanyPhoneConstraint::OnePhoneConstraint::is_one_phone_suite(const YellowPagesDatabase::CompanyPhone &phone_to_check)");
     }
 
+    uint8_t CompanyPhoneConstraint::OnePhoneConstraint::get_key_fields() const {
+        return key_fields_;
+    }
+
+    const std::string &CompanyPhoneConstraint::OnePhoneConstraint::get_packed_key() const {
+        return packed_key_;
+    }
+
     CompanyPhoneConstraint::CompanyPhoneConstraint(const std::vector<Json::Node> &names_json) : phone_constraints_(names_json.begin(), names_json.end()) {}
 
     bool CompanyPhoneConstraint::is_suite(const YellowPagesDatabase::Company &company_to_check) const {
@@ -89,6 +177,48 @@ namespace YellowPagesSearch {
         return false;
     }
 
+    const std::string &CompanyPhoneConstraint::get_name() const {
+        static const std::string name = "phones";
+        return name;
+    }
+
+    size_t CompanyPhoneConstraint::estimate_count(const YellowPagesDatabase::CompaniesIndex &index) const {
+        return EstimateUnitedCount(phone_constraints_, index, [&index](const OnePhoneConstraint &one_phone_constraint) -> const YellowPagesDatabase::CompanyIds & {
+            return index.FindByPhoneKey(one_phone_constraint.get_key_fields(), one_phone_constraint.get_packed_key());
+        });
+    }
+
+    void CompanyPhoneConstraint::append_cache_key(std::string &key) const {
+        // Phones with the same key fields and packed key suit the same companies
+        std::vector<std::pair<uint8_t, std::string_view>> phone_keys;
+        phone_keys.reserve(phone_constraints_.size());
+        for (const OnePhoneConstraint &one_phone_constraint : phone_constraints_) {
+            phone_keys.emplace_back(one_phone_constraint.get_key_fields(), one_phone_constraint.get_packed_key());
+        }
+        std::sort(phone_keys.begin(), phone_keys.end());
+        phone_keys.erase(std::unique(phone_keys.begin(), phone_keys.end()), phone_keys.end());
+
+        AppendNumberToCacheKey(key, phone_keys.size());
+        for (const auto &[key_fields, packed_key] : phone_keys) {
+            AppendNumberToCacheKey(key, key_fields);
+            AppendToCacheKey(key, packed_key);
+        }
+    }
+
+    bool CompanyPhoneConstraint::is_empty() const {
+        return phone_constraints_.empty();
+    }
+
+    YellowPagesDatabase::CompanyIds CompanyPhoneConstraint::find_suitable(const YellowPagesDatabase::CompaniesIndex &index,
+                                                                          const std::vector<YellowPagesDatabase::Company> &) const {
+        std::vector<const YellowPagesDatabase::CompanyIds *> ids_lists;
+        ids_lists.reserve(phone_constraints_.size());
+        for (const OnePhoneConstraint &one_phone_constraint : phone_constraints_) {
+            ids_lists.push_back(&index.FindByPhoneKey(one_phone_constraint.get_key_fields(), one_phone_constraint.get_packed_key()));
+        }
+        return YellowPagesDatabase::UniteCompanyIds(ids_lists);
+    }
+
     CompanyUrlConstraint::CompanyUrlConstraint(const std::vector<Json::Node> &urls_json) {
         for (const auto &url_json : urls_json) {
             urls_.insert(url_json.AsString());
@@ -100,11 +230,43 @@ namespace YellowPagesSearch {
 
         return std::any_of(company_to_check.get_company_urls().begin(),
                            company_to_check.get_company_urls().end(),
-                           [this](const std::string &company_url) {
+                           [this](std::string_view company_url) {
                                return urls_.count(company_url);
                            });
     }
 
+    const std::string &CompanyUrlConstraint::get_name() const {
+        static const std::string name = "urls";
+        return name;
+    }
+
+    size_t CompanyUrlConstraint::estimate_count(const YellowPagesDatabase::CompaniesIndex &index) const {
+        return EstimateUnitedCount(urls_, index, [&index](const std::string &url) -> const YellowPagesDatabase::CompanyIds & {
+            return index.FindByUrl(url);
+        });
+    }
+
+    void CompanyUrlConstraint::append_cache_key(std::string &key) const {
+        AppendNumberToCacheKey(key, urls_.size());
+        for (const auto &url : urls_) {  // sorted
+            AppendToCacheKey(key, url);
+        }
+    }
+
+    bool CompanyUrlConstraint::is_empty() const {
+        return urls_.empty();
+    }
+
+    YellowPagesDatabase::CompanyIds CompanyUrlConstraint::find_suitable(const YellowPagesDatabase::CompaniesIndex &index,
+                                                                        const std::vector<YellowPagesDatabase::Company> &) const {
+        std::vector<const YellowPagesDatabase::CompanyIds *> ids_lists;
+        ids_lists.reserve(urls_.size());
+        for (const auto &url : urls_) {
+            ids_lists.push_back(&index.FindByUrl(url));
+        }
+        return YellowPagesDatabase::UniteCompanyIds(ids_lists);
+    }
+
     CompanyRubricConstraint::CompanyRubricConstraint(const std::vector<Json::Node> &rubric_strs_json,
                                                      const std::unordered_map<std::string, uint64_t> &rubric_ids_dict) {
         for (const auto &one_rubric_str_json : rubric_strs_json) {
@@ -123,4 +285,87 @@ namespace YellowPagesSearch {
                                return rubrics_.count(company_rubric);
                            });
     }
-}
\ No newline at end of file
+
+    const std::string &CompanyRubricConstraint::get_name() const {
+        static const std::string name = "rubrics";
+        return name;
+    }
+
+    size_t CompanyRubricConstraint::estimate_count(const YellowPagesDatabase::CompaniesIndex &index) const {
+        return EstimateUnitedCount(rubrics_, index, [&index](uint64_t rubric_id) -> const YellowPagesDatabase::CompanyIds & {
+            return index.FindByRubric(rubric_id);
+        });
+    }
+
+    void CompanyRubricConstraint::append_cache_key(std::string &key) const {
+        // By the resolved ids, so that a rubric and its keywords share the key
+        std::vector<uint64_t> rubric_ids(rubrics_.begin(), rubrics_.end());
+        std::sort(rubric_ids.begin(), rubric_ids.end());
+
+        AppendNumberToCacheKey(key, rubric_ids.size());
+        for (uint64_t rubric_id : rubric_ids) {
+            AppendNumberToCacheKey(key, rubric_id);
+        }
+    }
+
+    bool CompanyRubricConstraint::is_empty() const {
+        return rubrics_.empty();
+    }
+
+    YellowPagesDatabase::CompanyIds CompanyRubricConstraint::find_suitable(const YellowPagesDatabase::CompaniesIndex &index,
+                                                                           const std::vector<YellowPagesDatabase::Company> &) const {
+        if (rubrics_.size() == 1) {
+            return index.FindByRubric(*rubrics_.begin());
+        }
+        return find_suitable_bitmap(index)->ToIds();
+    }
+
+    std::optional<YellowPagesDatabase::CompaniesBitmap> CompanyRubricConstraint::find_suitable_bitmap(const YellowPagesDatabase::CompaniesIndex &index) const {
+        YellowPagesDatabase::CompaniesBitmap suitable_bitmap(index.GetCompaniesCount());
+        for (uint64_t rubric_id : rubrics_) {
+            suitable_bitmap |= index.GetRubricBitmap(rubric_id);
+        }
+        return suitable_bitmap;
+    }
+
+    std::optional<size_t> CompanyRubricConstraint::estimate_bitmap_words(const YellowPagesDatabase::CompaniesIndex &index) const {
+        return rubrics_.size() * YellowPagesDatabase::CompaniesBitmap::GetWordsCount(index.GetCompaniesCount());
+    }
+
+    CompanyWorkingTimeConstraint::CompanyWorkingTimeConstraint(const std::vector<Json::Node> &datetime_json) {
+        if (datetime_json.empty()) { return; }
+
+        const int minute_of_week = datetime_json.at(0).AsInt() * YellowPagesDatabase::CompanyWorkingTime::MINUTES_IN_DAY
+                                   + datetime_json.at(1).AsInt() * 60 + datetime_json.at(2).AsInt();
+        minute_of_week_ = (minute_of_week % YellowPagesDatabase::CompanyWorkingTime::MINUTES_IN_WEEK + YellowPagesDatabase::CompanyWorkingTime::MINUTES_IN_WEEK)
+                          % YellowPagesDatabase::CompanyWorkingTime::MINUTES_IN_WEEK;
+    }
+
+    bool CompanyWorkingTimeConstraint::is_suite(const YellowPagesDatabase::Company &company_to_check) const {
+        if (!minute_of_week_) { return true; }
+
+        return company_to_check.get_company_working_time().is_open_at(*minute_of_week_);
+    }
+
+    const std::string &CompanyWorkingTimeConstraint::get_name() const {
+        static const std::string name = "datetime";
+        return name;
+    }
+
+    void CompanyWorkingTimeConstraint::append_cache_key(std::string &key) const {
+        AppendNumberToCacheKey(key, minute_of_week_.value_or(-1));
+    }
+
+    bool CompanyWorkingTimeConstraint::is_empty() const {
+        return !minute_of_week_.has_value();
+    }
+
+    size_t CompanyWorkingTimeConstraint::estimate_count(const YellowPagesDatabase::CompaniesIndex &index) const {
+        return index.CountOpenAt(*minute_of_week_);
+    }
+
+    YellowPagesDatabase::CompanyIds CompanyWorkingTimeConstraint::find_suitable(const YellowPagesDatabase::CompaniesIndex &index,
+                                                                                const std::vector<YellowPagesDatabase::Company> &) const {
+        return index.FindOpenAt(*minute_of_week_);
+    }
+}
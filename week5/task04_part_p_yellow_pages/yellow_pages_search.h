@@ -1,9 +1,13 @@
 #pragma once
 
+#include <optional>
+#include <set>
+#include <string>
 #include <vector>
 #include <unordered_set>
 
 #include "yellow_pages.h"
+#include "yellow_pages_index.h"
 
 
 namespace YellowPagesDatabase {
@@ -16,6 +20,28 @@ namespace YellowPagesSearch {
     class CompanyConstraint {
     public:
         virtual bool is_suite(const YellowPagesDatabase::Company &company_to_check) const = 0;
+
+        // Key of the constraint in FindCompanies requests
+        virtual const std::string &get_name() const = 0;
+
+        // Nothing to match, every company suits
+        virtual bool is_empty() const = 0;
+
+        // Upper bound of the suitable companies count, without looking them up
+        virtual size_t estimate_count(const YellowPagesDatabase::CompaniesIndex &index) const = 0;
+
+        // Ids of the suitable companies, looked up in the index instead of checking every company
+        virtual YellowPagesDatabase::CompanyIds find_suitable(const YellowPagesDatabase::CompaniesIndex &index,
+                                                              const std::vector<YellowPagesDatabase::Company> &companies) const = 0;
+
+        // Bitmap of exactly the suitable companies if the index keeps bitmaps for the constraint, nullopt otherwise
+        virtual std::optional<YellowPagesDatabase::CompaniesBitmap> find_suitable_bitmap(const YellowPagesDatabase::CompaniesIndex &index) const;
+
+        // Words of the bitmaps find_suitable_bitmap combines, nullopt if it has no bitmap
+        virtual std::optional<size_t> estimate_bitmap_words(const YellowPagesDatabase::CompaniesIndex &index) const;
+
+        // Appends the values of the constraint in a canonical form, the same for constraints with the same suitable companies
+        virtual void append_cache_key(std::string &key) const = 0;
     };
 
     class CompanyNameConstraint : public CompanyConstraint {
@@ -24,8 +50,19 @@ namespace YellowPagesSearch {
 
         bool is_suite(const ::YellowPagesDatabase::Company &company_to_check) const override;
 
+        const std::string &get_name() const override;
+
+        bool is_empty() const override;
+
+        size_t estimate_count(const YellowPagesDatabase::CompaniesIndex &index) const override;
+
+        void append_cache_key(std::string &key) const override;
+
+        YellowPagesDatabase::CompanyIds find_suitable(const YellowPagesDatabase::CompaniesIndex &index,
+                                                      const std::vector<YellowPagesDatabase::Company> &companies) const override;
+
     private:
-        std::unordered_set<std::string> names_;
+        std::set<std::string, std::less<>> names_;
     };
 
     class CompanyPhoneConstraint : public CompanyConstraint {
@@ -36,12 +73,20 @@ namespace YellowPagesSearch {
 
             bool is_one_phone_suite(const YellowPagesDatabase::CompanyPhone &phone_to_check) const;
 
+            uint8_t get_key_fields() const;
+
+            // PackPhoneKey of the constraint, equal to the one of every suitable phone with the same key fields
+            const std::string &get_packed_key() const;
+
         private:
             std::optional<::YellowPages::Phone_Type> type_;
             std::optional<std::string> country_code_;
             std::optional<std::string> local_code_;
             std::optional<std::string> number_;
             std::optional<std::string> extension_;
+
+            uint8_t key_fields_ = 0;
+            std::string packed_key_;
         };
 
     public:
@@ -49,6 +94,17 @@ namespace YellowPagesSearch {
 
         bool is_suite(const ::YellowPagesDatabase::Company &company_to_check) const override;
 
+        const std::string &get_name() const override;
+
+        bool is_empty() const override;
+
+        size_t estimate_count(const YellowPagesDatabase::CompaniesIndex &index) const override;
+
+        void append_cache_key(std::string &key) const override;
+
+        YellowPagesDatabase::CompanyIds find_suitable(const YellowPagesDatabase::CompaniesIndex &index,
+                                                      const std::vector<YellowPagesDatabase::Company> &companies) const override;
+
     private:
         std::vector<OnePhoneConstraint> phone_constraints_;
     };
@@ -59,8 +115,19 @@ namespace YellowPagesSearch {
 
         bool is_suite(const ::YellowPagesDatabase::Company &company_to_check) const override;
 
+        const std::string &get_name() const override;
+
+        bool is_empty() const override;
+
+        size_t estimate_count(const YellowPagesDatabase::CompaniesIndex &index) const override;
+
+        void append_cache_key(std::string &key) const override;
+
+        YellowPagesDatabase::CompanyIds find_suitable(const YellowPagesDatabase::CompaniesIndex &index,
+                                                      const std::vector<YellowPagesDatabase::Company> &companies) const override;
+
     private:
-        std::unordered_set<std::string> urls_;
+        std::set<std::string, std::less<>> urls_;
     };
 
     class CompanyRubricConstraint : public CompanyConstraint {
@@ -69,7 +136,44 @@ namespace YellowPagesSearch {
 
         bool is_suite(const ::YellowPagesDatabase::Company &company_to_check) const override;
 
+        const std::string &get_name() const override;
+
+        bool is_empty() const override;
+
+        size_t estimate_count(const YellowPagesDatabase::CompaniesIndex &index) const override;
+
+        void append_cache_key(std::string &key) const override;
+
+        YellowPagesDatabase::CompanyIds find_suitable(const YellowPagesDatabase::CompaniesIndex &index,
+                                                      const std::vector<YellowPagesDatabase::Company> &companies) const override;
+
+        std::optional<YellowPagesDatabase::CompaniesBitmap> find_suitable_bitmap(const YellowPagesDatabase::CompaniesIndex &index) const override;
+
+        std::optional<size_t> estimate_bitmap_words(const YellowPagesDatabase::CompaniesIndex &index) const override;
+
     private:
         std::unordered_set<uint64_t> rubrics_;
     };
-}
\ No newline at end of file
+
+    class CompanyWorkingTimeConstraint : public CompanyConstraint {
+    public:
+        // [day, hours, minutes], day from 0 (Monday) to 6; empty for any time
+        explicit CompanyWorkingTimeConstraint(const std::vector<Json::Node> &datetime_json);
+
+        bool is_suite(const ::YellowPagesDatabase::Company &company_to_check) const override;
+
+        const std::string &get_name() const override;
+
+        bool is_empty() const override;
+
+        size_t estimate_count(const YellowPagesDatabase::CompaniesIndex &index) const override;
+
+        void append_cache_key(std::string &key) const override;
+
+        YellowPagesDatabase::CompanyIds find_suitable(const YellowPagesDatabase::CompaniesIndex &index,
+                                                      const std::vector<YellowPagesDatabase::Company> &companies) const override;
+
+    private:
+        std::optional<int> minute_of_week_;
+    };
+}
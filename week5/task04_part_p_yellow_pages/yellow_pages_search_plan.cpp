@@ -0,0 +1,89 @@
+#include "yellow_pages_search_plan.h"
+
+#include <algorithm>
+
+#include "yellow_pages.h"
+#include "yellow_pages_search.h"
+
+
+namespace YellowPagesSearch {
+    std::string ToString(SearchPlanStep::Method method) {
+        switch (method) {
+            case SearchPlanStep::Method::INDEX_LOOKUP:
+                return "index_lookup";
+            case SearchPlanStep::Method::INTERSECTION:
+                return "intersection";
+            case SearchPlanStep::Method::FILTER:
+                return "filter";
+            case SearchPlanStep::Method::BITMAP_FILTER:
+                return "bitmap_filter";
+        }
+        throw std::runtime_error("ToString(SearchPlanStep::Method method)");
+    }
+
+    SearchPlanner::SearchPlanner(const YellowPagesDatabase::CompaniesIndex &index, const std::vector<YellowPagesDatabase::Company> &companies)
+            : index_(index), companies_(companies) {}
+
+    std::optional<YellowPagesDatabase::CompanyIds> SearchPlanner::Search(const CompanyConstraints &constraints, SearchPlan *plan) const {
+        struct PlannedConstraint {
+            const CompanyConstraint *constraint;
+            size_t estimated_count;
+        };
+        std::vector<PlannedConstraint> planned_constraints;
+        planned_constraints.reserve(constraints.size());
+        for (const CompanyConstraint *constraint_ptr : constraints) {
+            if (constraint_ptr->is_empty()) {
+                if (plan) {
+                    plan->skipped_constraint_names.push_back(constraint_ptr->get_name());
+                }
+                continue;
+            }
+            planned_constraints.push_back({constraint_ptr, constraint_ptr->estimate_count(index_)});
+        }
+        if (planned_constraints.empty()) {
+            return std::nullopt;
+        }
+        std::stable_sort(planned_constraints.begin(), planned_constraints.end(),
+                         [](const PlannedConstraint &lhs, const PlannedConstraint &rhs) {
+                             return lhs.estimated_count < rhs.estimated_count;
+                         });
+
+        YellowPagesDatabase::CompanyIds candidate_ids;
+        for (size_t step_idx = 0; step_idx < planned_constraints.size(); ++step_idx) {
+            const auto &[constraint_ptr, estimated_count] = planned_constraints[step_idx];
+
+            SearchPlanStep::Method method;
+            if (step_idx == 0) {
+                method = SearchPlanStep::Method::INDEX_LOOKUP;
+                candidate_ids = constraint_ptr->find_suitable(index_, companies_);
+            } else if (candidate_ids.size() * FILTER_COST_RATIO < estimated_count) {
+                const auto bitmap_words = constraint_ptr->estimate_bitmap_words(index_);
+                if (bitmap_words && *bitmap_words <= candidate_ids.size() * BITMAP_WORDS_PER_CANDIDATE) {
+                    method = SearchPlanStep::Method::BITMAP_FILTER;
+                    const auto suitable_bitmap = constraint_ptr->find_suitable_bitmap(index_);
+                    candidate_ids.erase(std::remove_if(candidate_ids.begin(), candidate_ids.end(),
+                                                       [&suitable_bitmap](YellowPagesDatabase::CompanyId company_id) {
+                                                           return !suitable_bitmap->Test(company_id);
+                                                       }),
+                                        candidate_ids.end());
+                } else {
+                    method = SearchPlanStep::Method::FILTER;
+                    candidate_ids.erase(std::remove_if(candidate_ids.begin(), candidate_ids.end(),
+                                                       [this, constraint_ptr = constraint_ptr](YellowPagesDatabase::CompanyId company_id) {
+                                                           return !constraint_ptr->is_suite(companies_[company_id]);
+                                                       }),
+                                        candidate_ids.end());
+                }
+            } else {
+                method = SearchPlanStep::Method::INTERSECTION;
+                candidate_ids = YellowPagesDatabase::IntersectCompanyIds(candidate_ids, constraint_ptr->find_suitable(index_, companies_));
+            }
+
+            if (plan) {
+                plan->steps.push_back({constraint_ptr->get_name(), method, estimated_count, candidate_ids.size()});
+            }
+            if (candidate_ids.empty()) { break; }
+        }
+        return candidate_ids;
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "yellow_pages_index.h"
+
+
+namespace YellowPagesDatabase {
+    class Company;
+}
+
+namespace YellowPagesSearch {
+    class CompanyConstraint;
+
+    using CompanyConstraints = std::array<const CompanyConstraint *, 5>;
+
+    struct SearchPlanStep {
+        enum class Method {
+            INDEX_LOOKUP,  // candidates are the companies found by the index
+            INTERSECTION,  // candidates are intersected with the companies found by the index
+            FILTER,        // every candidate is checked by the constraint itself
+            BITMAP_FILTER, // every candidate is checked by the bitmap of the constraint
+        };
+
+        std::string constraint_name;
+        Method method;
+        size_t estimated_count;
+        size_t candidates_count;  // after the step
+    };
+
+    // What SearchPlanner did for a search: skipped empty constraints and the executed steps in their order
+    struct SearchPlan {
+        std::vector<std::string> skipped_constraint_names;
+        std::vector<SearchPlanStep> steps;
+    };
+
+    std::string ToString(SearchPlanStep::Method method);
+
+    // Runs the nonempty constraints from the most selective one by the index estimate.
+    // A constraint whose estimate is much bigger than the current candidates count filters the candidates
+    // instead of fetching its companies from the index. The candidates are checked by the bitmap of the constraint
+    // if the index keeps one and they are many enough to pay for combining it, one by one otherwise.
+    class SearchPlanner {
+    public:
+        SearchPlanner(const YellowPagesDatabase::CompaniesIndex &index, const std::vector<YellowPagesDatabase::Company> &companies);
+
+        // Ids of the companies suitable for all the constraints, nullopt if none of the constraints restricts the search
+        std::optional<YellowPagesDatabase::CompanyIds> Search(const CompanyConstraints &constraints, SearchPlan *plan = nullptr) const;
+
+    private:
+        static constexpr size_t FILTER_COST_RATIO = 8;  // a posting list entry vs checking a candidate by the constraint
+        static constexpr size_t BITMAP_WORDS_PER_CANDIDATE = 16;  // a bitmap word combined vs checking a candidate by the constraint
+
+        const YellowPagesDatabase::CompaniesIndex &index_;
+        const std::vector<YellowPagesDatabase::Company> &companies_;
+    };
+}